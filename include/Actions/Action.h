@@ -12,6 +12,8 @@ public:
     virtual void Undo() = 0;
     virtual void Update() {}
     virtual std::string ToString() = 0;
+    // Only changes the value of an input, not the structure of the graph
+    virtual bool IsValueChange() const { return false; }
     virtual ~Action() = default;
 };
 
@@ -50,6 +52,7 @@ public:
 
 private:
     void CleanRedoneActions();
+    void OnActionApplied(const Action& action) const;
 
     bool IsInside(const ActionRef& action) const;
 
@@ -5,7 +5,7 @@
 class ActionCreateLink : public Action
 {
 public:
-    ActionCreateLink(NodeManager* nodeManager, const LinkRef& link);
+    ActionCreateLink(NodeManager* nodeManager, const Link& link);
 
     void Do() override;
     void Undo() override;
@@ -14,6 +14,6 @@ public:
 
 private:
     NodeManager* m_nodeManager = nullptr;
-    LinkRef m_link = nullptr;
+    Link m_link;
     
 };
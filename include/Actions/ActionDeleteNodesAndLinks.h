@@ -5,7 +5,7 @@
 class ActionDeleteNodesAndLinks : public Action
 {
 public:
-    ActionDeleteNodesAndLinks(NodeManager* nodeManager, const std::vector<NodeWeak>& nodes, const std::vector<LinkWeakRef>& links);
+    ActionDeleteNodesAndLinks(NodeManager* nodeManager, const std::vector<NodeWeak>& nodes, const std::vector<LinkHandle>& links);
 
     void Do() override;
     void Undo() override;
@@ -14,6 +14,6 @@ public:
 private:
     NodeManager* m_nodeManager = nullptr;
     std::vector<NodeRef> m_nodes = {};
-    std::vector<LinkRef> m_links = {};
+    std::vector<Link> m_links = {};
     
 };
@@ -26,5 +26,5 @@ private:
     NodeManager* m_nodeManager = nullptr;
 
     std::vector<NodeRef> m_pastedNodes;
-    std::vector<LinkRef> m_pastedLinks;
+    std::vector<Link> m_pastedLinks;
 };
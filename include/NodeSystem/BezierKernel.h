@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <galaxymath/Maths.h>
+
+using namespace GALAXY;
+
+// Control points of many cubic Bezier curves in structure of arrays layout
+struct BezierBatch
+{
+    std::vector<float> p0x, p0y;
+    std::vector<float> p1x, p1y;
+    std::vector<float> p2x, p2y;
+    std::vector<float> p3x, p3y;
+
+    void Add(const Vec2f controlPoints[4]);
+    void Clear();
+    uint32_t Size() const { return static_cast<uint32_t>(p0x.size()); }
+};
+
+// Hit-testing of many curves at once : the exact bounds of each curve are computed with SSE2 when available
+// to reject most curves, the remaining ones are refined by adaptive subdivision.
+namespace BezierKernel
+{
+    // Index of the first curve closer than threshold to the point, -1 if none
+    int32_t FindHit(const BezierBatch& batch, const Vec2f& point, float threshold);
+
+    // Set bit i of the mask when curve i intersects the rectangle, rectMin must be lower than rectMax
+    void IntersectRect(const BezierBatch& batch, const Vec2f& rectMin, const Vec2f& rectMax, std::vector<uint64_t>& mask);
+
+    inline bool IsSet(const std::vector<uint64_t>& mask, uint32_t index) { return mask[index / 64] >> (index % 64) & 1; }
+}
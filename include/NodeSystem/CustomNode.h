@@ -31,8 +31,6 @@ public:
     std::string GetFunctionName() const;
     std::vector<std::string> GetFormatStrings() const override;
 
-    std::string ToShader(ShaderMaker* shaderMaker, const FuncStruct& funcStruct) const override;
-
     void ClearInputs();
     void ClearOutputs();
 private:
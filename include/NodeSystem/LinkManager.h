@@ -1,10 +1,15 @@
 ﻿#pragma once
 #include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 #include <Maths.h>
 
+#include "BezierKernel.h"
 #include "Node.h"
+#include "SlotMap.h"
+#include "SpatialGrid.h"
+#include "TopologicalOrder.h"
 #include "UUID.h"
 
 struct Link
@@ -16,8 +21,25 @@ struct Link
     uint32_t toInputIndex = -1;
 };
 
-using LinkRef = std::shared_ptr<Link>;
-using LinkWeakRef = std::weak_ptr<Link>;
+using LinkList = SlotMap<Link>;
+
+// Curve of a link flattened in grid space, rebuilt when one of its nodes moves.
+// No points when one of the linked nodes does not exist
+struct LinkCurve
+{
+    Vec2f controlPoints[4];
+    std::vector<Vec2f> points;
+    // Bounds of the control points padded by the pick threshold, the curve and its pick area are inside
+    Vec2f min;
+    Vec2f max;
+};
+
+// Links connected to a node, indexed by stream slot
+struct NodeLinks
+{
+    std::vector<std::vector<LinkHandle>> inputs;
+    std::vector<std::vector<LinkHandle>> outputs;
+};
 
 class LinkManager
 {
@@ -31,13 +53,15 @@ public:
     void CreateLink(const NodeRef& fromNode, uint32_t fromOutput, const NodeRef& toNode, uint32_t toOutput);
     void CreateLink(UUID fromNodeIndex, uint32_t fromOutputIndex, UUID toNodeIndex, uint32_t toOutputIndex);
 
-    LinkWeakRef AddLink(Link link);
-    void AddLink(const LinkRef& link);
+    // Invalid handle if the link would close a cycle
+    LinkHandle AddLink(const Link& link);
 
-    void RemoveLink(uint32_t index, bool removeOnLink = true);
+    // Reaches the link through its handle and unindexes it from its two streams, no other link is visited
+    void RemoveLink(const LinkHandle& link, bool removeOnLink = true);
     void RemoveLink(const NodeRef& fromNode, uint32_t fromOutput, const NodeRef& toNode, uint32_t toOutput);
     void RemoveLink(const UUID& fromNodeIndex, uint32_t fromOutputIndex, const UUID& toNodeIndex, uint32_t toOutputIndex);
-    void RemoveLink(const LinkWeakRef& link);
+    // Removes the stored link equal to this one
+    void RemoveLink(const Link& link);
     // Removes the link connected to the input
     void RemoveLink(const InputRef& input);
     // Removes all links connected to the output
@@ -45,44 +69,70 @@ public:
     
     void RemoveLinks(const NodeRef& node);
 
-    bool CanCreateLink(const Link& link) const;
-    
+    // Rebuild the curves of the links connected to the node, called when it moves or is resized
+    void UpdateLinkCurves(const UUID& nodeUUID);
 
+    bool CanCreateLink(const Link& link) const;
 
-    static bool IsPointHoverLineSegment(Vec2f pointPosition, Vec2f fromPosition, Vec2f toPosition, float threshold = 1);
-    static bool IsPointHoverBezier(Vec2f pointPosition, Vec2f inputPosition, Vec2f controlPoint1, Vec2f controlPoint2, Vec2f outputPosition, float threshold = 1, int numSamples = 10);
-    static bool BezierIntersectSquare(Vec2f inputPosition, Vec2f controlPoint1, Vec2f controlPoint2, Vec2f outputPosition, Vec2f rectMin, Vec2f rectMax);
+    // nullptr if the link was removed
+    const Link* GetLink(const LinkHandle& link) const { return m_links.Get(link); }
 
-    std::vector<LinkWeakRef> GetLinksWithOutput(const OutputRef& output) const;
-    LinkWeakRef GetLinkLinkedToInput(const UUID& uuid, uint32_t index) const;
-    std::vector<LinkWeakRef> GetLinksWithInput(const UUID& uuid, uint32_t index) const;
-    const std::vector<LinkRef>& GetLinks() const { return m_links; }
-    const std::vector<LinkWeakRef>& GetSelectedLinks() { return m_selectedLinks;}
+    std::vector<LinkHandle> GetLinksWithOutput(const OutputRef& output) const;
+    LinkHandle GetLinkLinkedToInput(const UUID& uuid, uint32_t index) const;
+    std::vector<LinkHandle> GetLinksWithInput(const UUID& uuid, uint32_t index) const;
+    std::vector<LinkHandle> GetLinksWithNode(const UUID& uuid) const;
+    const std::vector<Link>& GetLinks() const { return m_links.GetValues(); }
+    const std::vector<LinkHandle>& GetSelectedLinks() { return m_selectedLinks;}
+    // Order of the linked nodes, each node before the nodes it feeds
+    const TopologicalOrder& GetTopologicalOrder() const { return m_order; }
+    // Incremented each time the links change, used to invalidate what is computed from the graph
+    uint64_t GetGraphVersion() const { return m_graphVersion; }
 
     bool HasLink(const OutputRef& output) const;
     bool HasLink(const InputRef& input) const;
     
-    LinkWeakRef GetLinkClicked(float zoom, const Vec2f& origin, const Vec2f& mousePos) const;
+    LinkHandle GetLinkClicked(float zoom, const Vec2f& origin, const Vec2f& mousePos) const;
 
-    void AddSelectedLink(const LinkRef& link);
+    void AddSelectedLink(const LinkHandle& link);
 
     void DeleteSelectedLinks();
     void ClearSelectedLinks();
     
     void Serialize(CppSer::Serializer& serializer) const;
-    static void Serialize(CppSer::Serializer& serializer, const std::vector<LinkRef>& links);
+    static void Serialize(CppSer::Serializer& serializer, const std::vector<Link>& links);
     void Deserialize(CppSer::Parser& parser);
-    static void Deserialize(CppSer::Parser& parser, std::vector<LinkRef>& links);
+    static void Deserialize(CppSer::Parser& parser, std::vector<Link>& links);
 
     void Clean();
 
     NodeWindow* GetMainWindow() const;
 
+private:
+    // Store the link and index it, without touching the linked state of its streams. Invalid handle if it closes a cycle
+    LinkHandle InsertLink(const Link& link);
+    void IndexLink(const LinkHandle& link);
+    void UnindexLink(const LinkHandle& link);
+    const NodeLinks* GetNodeLinks(const UUID& uuid) const;
+    // Control points in grid space, false if one of the nodes does not exist
+    bool GetLinkControlPoints(const Link& link, Vec2f controlPoints[4]) const;
+    void UpdateLinkCurve(const LinkHandle& link);
+    // nullptr if the link was removed or one of its nodes does not exist
+    const LinkCurve* GetLinkCurve(const LinkHandle& link) const;
+    void DrawLinkCurve(ImDrawList* drawList, const LinkCurve& curve, float zoom, const Vec2f& origin, uint32_t color, float thickness);
+
 private:
     NodeManager* m_nodeManager = nullptr;
     
-    std::vector<LinkRef> m_links;
-    std::vector<LinkWeakRef> m_selectedLinks;
+    LinkList m_links;
+    std::unordered_map<UUID, NodeLinks> m_nodeLinks;
+    TopologicalOrder m_order;
+    uint64_t m_graphVersion = 0;
+    std::vector<LinkCurve> m_linkCurves; // Indexed like the dense link storage
+    SpatialGrid<LinkHandle> m_linkGrid; // Bounds of the link curves
+    std::vector<ImVec2> m_screenPoints; // Curve points converted to screen space when drawing
+    BezierBatch m_linkBatch; // Candidates of the selection square
+    std::vector<uint64_t> m_selectionMask;
+    std::vector<LinkHandle> m_selectedLinks;
     
     float m_controlDistanceX = 50.f;
     int m_bezierSegmentCount = 25;
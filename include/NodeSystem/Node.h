@@ -4,6 +4,7 @@
 #include <galaxymath/maths.h>
 
 #include "NodeSystem/Selectable.h"
+#include "NodeSystem/SlotMap.h"
 
 #include "UUID.h"
 #include "Type.h"
@@ -12,7 +13,10 @@ class Framebuffer;
 class Shader;
 class NodeManager;
 class ShaderMaker;
-struct FuncStruct;
+class Node;
+using NodeHandle = SlotHandle<Node>;
+struct Link;
+using LinkHandle = SlotHandle<Link>;
 using namespace GALAXY;
 #include <imgui.h>
 
@@ -168,8 +172,7 @@ public:
     Vec2f GetOutputPosition(uint32_t index, const Vec2f& origin, float zoom) const;
     Vec2f GetOutputPosition(uint32_t index) const;
 
-    using LinkWeakRef = std::weak_ptr<struct Link>;
-    std::vector<LinkWeakRef> GetLinks() const;
+    std::vector<LinkHandle> GetLinks() const;
 
     void SetPosition(const Vec2f& position);
     void SetName(std::string name) { p_name = std::move(name); }
@@ -178,6 +181,7 @@ public:
     void ComputeNodeSize();
 
     UUID GetUUID() const { return p_uuid; }
+    NodeHandle GetHandle() const { return p_handle; }
     std::string GetName() const { return p_name; }
     Vec2f GetPosition() const { return p_position; }
     Vec2f GetSize() const { return p_size; }
@@ -199,8 +203,6 @@ public:
     virtual void Deserialize(CppSer::Parser& parser);
     virtual void InternalDeserialize(CppSer::Parser& parser);
 
-    virtual std::string ToShader(ShaderMaker* shaderMaker, const FuncStruct& funcStruct) const;
-
     virtual Node* Clone() const;
 
     virtual void OnChangeUUID(const UUID& prevUUID, const UUID& newUUID);
@@ -208,6 +210,8 @@ public:
     void OpenPreview(bool open);
 protected:
     void SetUUID(const UUID& uuid);
+    // Update the NodeManager hot data after a geometry change
+    void SyncHotData() const;
 
     void Internal_Clone(Node* node) const;
 
@@ -219,6 +223,7 @@ protected:
     friend class NodeManager;
     
     UUID p_uuid;
+    NodeHandle p_handle; // Handle in the NodeManager storage, invalid while the node is not added
     std::string p_name;
     
     std::vector<InputRef> p_inputs;
@@ -238,7 +243,6 @@ protected:
 
     bool p_allowInteraction = true; // Used for nodes that are not supposed to be delted or copied
     bool p_alwaysVisibleOnContext = false;
-    bool p_isVisible = true;
     bool p_computed = false;
 
     bool p_previewHovered = false;
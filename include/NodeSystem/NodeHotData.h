@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <galaxymath/Maths.h>
+
+using namespace GALAXY;
+
+// Structure of arrays mirror of the node bounds and selection.
+// Indexed like the NodeManager dense node storage, positions and sizes are in grid space.
+// The bounds tell when the node grid must be updated, culling and picking query the grid.
+struct NodeHotData
+{
+    enum Flags : uint8_t
+    {
+        None = 0,
+        Selected = 1 << 0,
+    };
+
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> sizeX;
+    std::vector<float> sizeY; // Include the preview when opened
+    std::vector<uint8_t> flags;
+
+    uint32_t Size() const { return static_cast<uint32_t>(flags.size()); }
+
+    void PushBack()
+    {
+        positionX.push_back(0.f);
+        positionY.push_back(0.f);
+        sizeX.push_back(0.f);
+        sizeY.push_back(0.f);
+        flags.push_back(None);
+    }
+
+    // Same removal as SlotMap::Erase so both stay in sync
+    void SwapRemove(uint32_t index)
+    {
+        const uint32_t last = Size() - 1;
+        positionX[index] = positionX[last];
+        positionY[index] = positionY[last];
+        sizeX[index] = sizeX[last];
+        sizeY[index] = sizeY[last];
+        flags[index] = flags[last];
+
+        positionX.pop_back();
+        positionY.pop_back();
+        sizeX.pop_back();
+        sizeY.pop_back();
+        flags.pop_back();
+    }
+
+    void Clear()
+    {
+        positionX.clear();
+        positionY.clear();
+        sizeX.clear();
+        sizeY.clear();
+        flags.clear();
+    }
+
+    bool HasFlag(uint32_t index, Flags flag) const { return flags[index] & flag; }
+
+    void SetFlag(uint32_t index, Flags flag, bool value)
+    {
+        flags[index] = value ? flags[index] | flag : flags[index] & ~flag;
+    }
+
+    Vec2f GetMin(uint32_t index) const { return { positionX[index], positionY[index] }; }
+    Vec2f GetMax(uint32_t index) const { return { positionX[index] + sizeX[index], positionY[index] + sizeY[index] }; }
+};
@@ -7,15 +7,18 @@
 
 #include "Event.h"
 #include "LinkManager.h"
+#include "SlotMap.h"
+#include "SpatialGrid.h"
 #include "UUID.h"
 
 #include "Node.h"
+#include "NodeHotData.h"
 #include "Type.h"
 
 
 class NodeWindow;
 class LinkManager;
-using NodeList = std::pmr::unordered_map<UUID, NodeRef>;
+using NodeList = SlotMap<NodeRef, Node>;
 struct SelectionSquare
 {
     Vec2f mousePosOnStart;
@@ -39,7 +42,7 @@ std::string UserInputEnumToString(UserInputState userInputState);
 struct SerializedData
 {
     std::vector<NodeRef> nodes;
-    std::vector<LinkRef> links;
+    std::vector<Link> links;
 };
 
 class NodeManager
@@ -60,9 +63,12 @@ public:
     
     void UpdateInputOutputClick(float zoom, const Vec2f& origin, const Vec2f& mousePos, bool mouseClicked, const NodeRef& node);
     void UpdateCurrentLink();
-    void UpdateNodeSelection(NodeRef node, float zoom, const Vec2f& origin, const Vec2f& mousePos, bool mouseClicked, bool ctrlDown, bool& wasNodeClicked);
+    void UpdateNodeSelection(const NodeRef& node, float zoom, const Vec2f& origin, const Vec2f& mousePos, bool mouseClicked, bool ctrlDown, bool& wasNodeClicked);
     void UpdateDragging(float zoom, const Vec2f& origin, const Vec2f& mousePos);
     void UpdateSelectionSquare(float zoom, const Vec2f& origin, const Vec2f& mousePos);
+    void SelectNodesInSquare(const Vec2f& min, const Vec2f& max);
+    // Nodes overlapping the grid space rectangle, in draw order
+    void QueryNodes(const Vec2f& min, const Vec2f& max, std::vector<NodeHandle>& result) const;
     void UpdateDelete();
 
     void DrawNodes(float zoom, const Vec2f& origin, const Vec2f& mousePos) const;
@@ -72,17 +78,28 @@ public:
     void AddSelectedNode(const NodeRef& node);
     void RemoveSelectedNode(const NodeWeak& node);
     void ClearSelectedNodes();
+
+    void SyncHotData(const Node& node);
     
     LinkManager* GetLinkManager() const { return m_linkManager; }
     NodeWeak GetNode(const UUID& uuid) const;
+    // Resolve without touching the reference count, nullptr if the node does not exist
+    Node* GetNode(const NodeHandle& handle) const;
+    Node* FindNode(const UUID& uuid) const;
+    NodeHandle GetHandle(const UUID& uuid) const;
+    const std::vector<NodeRef>& GetNodes() const { return m_nodes.GetValues(); }
     NodeWeak GetNodeWithTemplate(TemplateID templateID);
     NodeWeak GetNodeWithName(const std::string& name);
     std::vector<NodeWeak> GetNodeConnectedTo(const UUID& uuid) const;
-    bool NodeExists(const UUID& uuid) const { return m_nodes.find(uuid) != m_nodes.end(); }
-    InputWeak GetInput(const UUID& uuid, const uint32_t index) { return m_nodes[uuid]->GetInput(index); }
-    OutputWeak GetOutput(const UUID& uuid, const uint32_t index) { return m_nodes[uuid]->GetOutput(index); }
-    std::vector<LinkWeakRef> GetLinkWithOutput(const UUID& uuid, uint32_t index) const;
+    // Nodes the node depends on followed by the node itself, each node placed before the nodes it feeds.
+    // Cached until the links change
+    const std::vector<NodeWeak>& GetEvaluationOrder(const UUID& uuid) const;
+    bool NodeExists(const UUID& uuid) const { return m_uuidToHandle.contains(uuid); }
+    InputWeak GetInput(const UUID& uuid, const uint32_t index) const { return FindNode(uuid)->GetInput(index); }
+    OutputWeak GetOutput(const UUID& uuid, const uint32_t index) const { return FindNode(uuid)->GetOutput(index); }
+    std::vector<LinkHandle> GetLinkWithOutput(const UUID& uuid, uint32_t index) const;
     NodeWeak GetSelectedNode() const;
+    std::vector<NodeWeak> GetSelectedNodes() const;
     Link& GetCurrentLink() {return m_currentLink;}
     std::filesystem::path GetFilePath() const {return m_savePath;}
     NodeWindow* GetMainWindow() const { return m_parent; }
@@ -125,9 +142,17 @@ private:
     NodeWindow* m_parent;
     LinkManager* m_linkManager = nullptr;
     NodeList m_nodes;
+    std::unordered_map<UUID, NodeHandle> m_uuidToHandle;
+    NodeHotData m_hotData;
+    SpatialGrid<NodeHandle> m_nodeGrid;
+    std::vector<NodeHandle> m_uncomputedNodes;
+    std::vector<NodeHandle> m_visibleNodes;
+    std::vector<NodeHandle> m_hoveredNodes;
+    mutable std::unordered_map<UUID, std::vector<NodeWeak>> m_evaluationOrders;
+    mutable uint64_t m_evaluationOrdersVersion = UINT64_MAX; // Link graph version the orders were computed with
     
     Link m_currentLink; // The link when creating a new link
-    std::vector<NodeWeak> m_selectedNodes;
+    std::vector<NodeHandle> m_selectedNodes;
     Weak<Stream> m_hoveredStream;
 
     InputWeak m_currentInput;
@@ -1,9 +1,11 @@
 ﻿#pragma once
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "NodeSystem/Node.h"
+#include "NodeSystem/ShaderFormat.h"
 
 class Node;
 
@@ -28,6 +30,8 @@ struct NodeMethodInfo
 
     NodeRef node;
     std::vector<std::string> outputFormatStrings;
+    // Parsed from outputFormatStrings when the template is added
+    std::vector<ShaderFormatRef> outputFormats;
     std::vector<std::string> searchStrings;
 };
 
@@ -48,6 +52,7 @@ public:
     void ComputeNodesSize();
 
     static std::vector<std::string> GetTemplateFormatStrings(TemplateID templateID);
+    static const std::vector<ShaderFormatRef>& GetTemplateFormats(TemplateID templateID);
 
     void AddTemplateNode(const NodeMethodInfo& info);
     static TemplateID TemplateIDFromString(const std::string& name);
@@ -66,10 +71,14 @@ private:
                             const std::vector<std::tuple<std::string, Type>>& outputs, const std::string& format,
                             const std::vector<std::string>& searchStrings = {});
 
+    // Index the templates by ID, to call after an ID changes
+    void UpdateTemplateIndices();
+
 private:
     static std::unique_ptr<NodeTemplateHandler> s_instance;
 
     TemplateList m_templateNodes;
+    std::unordered_map<TemplateID, size_t> m_templateIndices;
 
     bool m_computed = false;
 };
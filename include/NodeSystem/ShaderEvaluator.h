@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "NodeSystem/ShaderIR.h"
+
+// Evaluate the built-in templates on the CPU, the template is recognized by its GLSL format.
+// Follows the GLSL rules : functions apply to each component and a float operand is used for every component
+class ShaderEvaluator
+{
+public:
+    // Returns false if the format is unknown or the result is not a finite literal
+    static bool Evaluate(const std::string& format, Type type, const std::vector<const IRValue*>& operands, Vec4f& result);
+
+    static uint32_t GetComponentCount(Type type);
+
+private:
+    static bool EvaluateConstructor(const std::string& format, Type type, const std::vector<const IRValue*>& operands, Vec4f& result);
+};
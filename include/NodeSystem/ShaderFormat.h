@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Format of a shader expression, parsed once into the literal slices around its %s argument slots
+class ShaderFormat
+{
+public:
+    ShaderFormat() : ShaderFormat(std::string()) {}
+    explicit ShaderFormat(std::string format);
+
+    const std::string& GetString() const { return m_format; }
+    uint64_t GetHash() const { return m_hash; }
+    uint32_t GetArgumentCount() const { return static_cast<uint32_t>(m_slices.size()) - 1; }
+
+    // Each slot receives the next argument, the extra arguments are ignored and a slot without argument is kept as %s
+    void Append(std::string& output, const std::vector<std::string_view>& arguments) const;
+
+    bool operator==(const ShaderFormat& other) const { return m_format == other.m_format; }
+
+private:
+    struct Slice
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    std::string m_format;
+    std::vector<Slice> m_slices; // One more than the argument slots
+    uint64_t m_hash = 0;
+};
+
+using ShaderFormatRef = std::shared_ptr<const ShaderFormat>;
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "NodeSystem/Node.h"
+#include "NodeSystem/ShaderFormat.h"
+
+class NodeManager;
+class LinkManager;
+
+inline void HashCombine(uint64_t& seed, uint64_t value)
+{
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+using IRValueID = uint32_t;
+constexpr IRValueID c_invalidIRValue = UINT32_MAX;
+
+enum class IROp : uint8_t
+{
+    Constant, // Value of an unlinked input, written as a literal where it is used
+    Template, // Output of a template node, the format string is applied to the operands
+    Param,    // Output of a param node, reads a builtin or a uniform by name
+    Custom,   // Output of a custom node, one function call writes all the outputs of the node
+    Uniform,  // Value of an unlinked input read from a uniform, its value changes without a new shader
+};
+
+// One value per node output, in static single assignment form : each value is written once
+// and its operands always come before it
+struct IRValue
+{
+    IROp op = IROp::Constant;
+    Type type = Type::None;
+    TemplateID templateID = 0;
+    UUID node = UUID_NULL;
+    uint32_t output = 0; // Index of the output in the node, of the input for uniforms
+    std::vector<IRValueID> operands; // One per node input
+    ShaderFormatRef format; // Expression of the output, the call for custom nodes. Shared with the template
+    std::string name; // Variable name in the generated code
+    Vec4f constant; // Only for constants
+    InputWeak input; // Only for uniforms, the input whose value is uploaded
+};
+
+struct IRCustomFunction
+{
+    UUID node;
+    std::string declaration;
+    std::string content;
+};
+
+// Values bound to the streams of a node, kept up to date by the passes
+struct IRNode
+{
+    std::vector<IRValueID> inputs;
+    std::vector<IRValueID> outputs; // c_invalidIRValue once removed
+};
+
+// Typed representation of the nodes, built once per compile and lowered to GLSL
+struct ShaderIR
+{
+    std::vector<IRValue> values; // Evaluation order
+    std::vector<IRCustomFunction> customFunctions;
+    std::unordered_map<UUID, IRNode> nodes;
+    UUID endNode = UUID_NULL; // Only set when built for one end node
+    // Unlinked inputs read uniforms instead of literals, kept by Clear. A uniform is never a constant, so in this mode :
+    // - FoldConstants folds nothing that reads an unlinked input
+    // - ShaderSimplifier only applies its structural rules, the ones keyed on a literal (x + 0, x * 1, pow, x / c) never match
+    // - EliminateCommonSubexpressions merges the values reading the same uniform, two inputs with equal values stay apart
+    // EliminateDeadValues works the same in both modes
+    bool uniformInputs = false;
+
+    // Build the nodes the end node depends on
+    void Build(NodeManager* manager, const NodeRef& endNode);
+    // Build every node of the graph once, each preview reads the values its node depends on
+    void BuildGraph(NodeManager* manager);
+    void Clear();
+
+    // Value written to the output color : the first output of a node, or the first linked input of the end node
+    IRValueID GetResult(const UUID& node) const;
+    // The inputs of the node and its result
+    std::vector<IRValueID> GetRoots(const UUID& node) const;
+    // Set live to the values read to compute the roots
+    void MarkLive(const std::vector<IRValueID>& roots, std::vector<bool>& live) const;
+
+    // Replace the template values whose operands are all constants by their result.
+    // Params and custom nodes are never constant, so nothing depending on them is folded
+    void FoldConstants();
+    // Hash-consing : values computing the same thing from the same operands are merged into the first one
+    void EliminateCommonSubexpressions();
+
+    // Remove the values nothing reads, starting from the roots of the end node.
+    // A custom node keeps all its outputs when one is read since one call writes them all
+    void EliminateDeadValues();
+
+    bool IsConstant(IRValueID id) const { return values[id].op == IROp::Constant; }
+    // Constants and uniforms are only read, no statement writes them
+    bool HasStatement(IRValueID id) const { return values[id].op != IROp::Constant && values[id].op != IROp::Uniform; }
+    // Number of values of the node starting at first, a constant or a uniform is alone
+    uint32_t GetValueCount(IRValueID first) const;
+
+private:
+    void AddNode(LinkManager* linkManager, const NodeRef& node);
+    IRValueID AddConstant(Type type, const Vec4f& value);
+    IRValueID AddUniform(const NodeRef& node, uint32_t index);
+
+    uint64_t HashComputation(IRValueID first) const;
+    bool IsSameComputation(IRValueID a, IRValueID b) const;
+    // Keep the values whose replacement is themselves, and point everything to the kept values.
+    // A value replaced by c_invalidIRValue is removed
+    void Compact(const std::vector<IRValueID>& replacements);
+};
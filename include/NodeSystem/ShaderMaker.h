@@ -1,55 +1,83 @@
 ﻿#pragma once
-#include <deque>
-#include <set>
 
 #include "NodeSystem/NodeManager.h"
 #include "NodeSystem/NodeTemplateHandler.h"
+#include "NodeSystem/ShaderIR.h"
+#include "Render/Framebuffer.h"
 
-struct FuncStruct
+// Statements emitted for one node, reused until one of the things they are made of changes
+struct ShaderSnippet
 {
-    std::string debugName;
-    std::vector<std::string> inputs;
-    std::vector<std::string> outputs;
+    uint64_t key = 0;
+    std::string code;
 };
 
-
-template<typename ... Args>
-std::string FormatString( const std::string& format, Args ... args )
-{
-    int size_s = std::snprintf( nullptr, 0, format.c_str(), args ... ) + 1; // Extra space for '\0'
-    if( size_s <= 0 ){ throw std::runtime_error( "Error during formatting." ); }
-    auto size = static_cast<size_t>( size_s );
-    std::unique_ptr<char[]> buf( new char[ size ] );
-    std::snprintf( buf.get(), size, format.c_str(), args ... );
-    return std::string( buf.get(), buf.get() + size - 1 ); // We don't want the '\0' inside
-}
-
 class ShaderMaker
 {
 public:
-    void FormatWithType(std::string& toFormat, InputRef input, std::string firstHalf);
-    
-    void FillFunctionList(NodeManager* manager, NodeRef firstNode);
-    void FillRecurrence(NodeManager* manager, const NodeRef& node);
+    // Tests of the IR passes and of the emitted shaders, each on its own graph
+    static void RunUnitTests();
 
+    // Build the IR of the whole graph once, assemble the shaders of the previews on the worker pool,
+    // then submit every compile without waiting for the driver
     void DoWork(NodeManager* manager);
     void CreateFragmentShader(std::string& content, NodeManager* manager);
     void CreateFragmentShader(const std::filesystem::path& path, NodeManager* manager);
-    void CreateFragmentShader(std::string& content, NodeManager* manager, const NodeRef& endNode);
+    // exported : for use outside the editor, the time is a plain uniform instead of a member of the globals block
+    void CreateFragmentShader(std::string& content, NodeManager* manager, const NodeRef& endNode, bool exported = false);
+    // Shader of a node made of the values it depends on in the current IR, with the uniforms it reads
+    void AssembleFragmentShader(std::string& content, const UUID& endNode, std::vector<ShaderUniform>* uniforms = nullptr);
     void CreateShaderToyShader(NodeManager* manager);
-    void SerializeFunctions(NodeManager* manager, const NodeRef& node, std::string& content);
 
+    const ShaderIR& GetIR() const { return m_ir; }
+    // Emit the unlinked inputs as uniforms, a value edit then only needs new uniform values but the passes
+    // keyed on literals no longer apply (see ShaderIR::uniformInputs). Exports always write literals
+    void SetUniformInputs(bool uniformInputs) { m_ir.uniformInputs = uniformInputs; }
+    bool GetUniformInputs() const { return m_ir.uniformInputs; }
+    // Remove the snippets of the nodes that no longer exist
+    void PruneSnippets(NodeManager* manager);
+
+    // GLSL float literal that reads back as the same value
+    static std::string GetFloatAsString(float value);
     static std::string GetValueAsString(InputRef input);
+    static std::string GetValueAsString(Type type, const Vec4f& value);
 
     static void CleanString(std::string& name);
     static std::string GetOutputVariableName(NodeRef currentNode, int j);
+    static std::string GetInputUniformName(const NodeRef& node, uint32_t index);
     static std::string TypeToGLSLType(Type type);
+
 private:
-    friend class Node;
-    friend class CustomNode;
-    std::unordered_map<UUID, FuncStruct> m_functions;
+    // Build the IR of the end node and run the passes on it
+    void BuildIR(NodeManager* manager, const NodeRef& endNode);
+    // Build the IR of every node, nothing is removed since each preview reads a different part
+    void BuildGraphIR(NodeManager* manager);
+
+    // Lowering of the IR to GLSL
+    std::string GetOperandString(IRValueID id) const;
+    // Emit again the snippets of the nodes with a live value whose key changed, on the worker pool.
+    // A node is emitted whole so its snippet is shared by every preview
+    void UpdateSnippets(const std::vector<bool>& live);
+    // Only reads the snippets, several shaders can be written at once
+    void AppendSnippets(std::string& content, const std::vector<bool>& live) const;
+    void WriteFragmentShader(std::string& content, const UUID& endNode, const std::vector<bool>& live, std::vector<ShaderUniform>* uniforms, bool exported = false) const;
+    // Key of the statements of the node whose first value is given : template, formats, names, input bindings and constant values
+    uint64_t GetSnippetKey(IRValueID first) const;
+    void EmitNode(IRValueID first, std::string& code) const;
+    std::string GetOutputColor(IRValueID result) const;
 
-    std::deque<std::string> m_variablesNames;
-    std::set<std::string> m_allVariableNames;
-    std::vector<NodeWeak> m_nodesToSerialize;
+    // Run by RunUnitTests, each builds its own graph
+    static void TestIRBuild();
+    static void TestSnippetCache();
+    static void TestGraphPreview();
+    static void TestUniformInputs();
+    static void TestCommonSubexpressions();
+    static void TestConstantFolding();
+    static void TestSimplification();
+    static void TestShaderFormat();
+
+private:
+    ShaderIR m_ir;
+    std::unordered_map<UUID, ShaderSnippet> m_snippets;
+    uint32_t m_emittedSnippetCount = 0;
 };
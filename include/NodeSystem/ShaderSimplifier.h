@@ -0,0 +1,36 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "NodeSystem/ShaderIR.h"
+
+enum class SimplifyRule : uint8_t
+{
+    AddZero,          // x + 0, 0 + x -> x
+    SubtractZero,     // x - 0 -> x
+    MultiplyOne,      // x * 1, 1 * x -> x
+    DivideByConstant, // x / c -> x * (1 / c), when 1 / c is a normal float
+    PowerOne,         // pow(x, 1) -> x
+    PowerToMultiply,  // pow(x, 2..4) -> x * x ...
+    SaturateSaturate, // saturate(saturate(x)) -> saturate(x)
+    OneMinusOneMinus, // 1 - (1 - x) -> x
+    Count
+};
+
+// Rewrite rules on the template values of the IR, keyed on the template IDs of the built-in templates
+class ShaderSimplifier
+{
+public:
+    static void Simplify(ShaderIR& ir);
+
+    static const char* GetRuleName(SimplifyRule rule);
+    // Number of times the rule was applied since the start or the last reset
+    static uint64_t GetHitCount(SimplifyRule rule) { return s_hitCounts[static_cast<size_t>(rule)]; }
+    static void ResetHitCounts();
+
+private:
+    static void AddHit(SimplifyRule rule);
+
+    static std::array<std::atomic<uint64_t>, static_cast<size_t>(SimplifyRule::Count)> s_hitCounts;
+};
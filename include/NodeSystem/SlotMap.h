@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Compact handle to an element of a SlotMap, the generation is bumped each time a slot is reused
+template <typename Tag>
+struct SlotHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+
+    bool operator==(const SlotHandle& other) const = default;
+};
+
+namespace std
+{
+    template <typename Tag>
+    struct hash<SlotHandle<Tag>>
+    {
+        size_t operator()(const SlotHandle<Tag>& handle) const noexcept
+        {
+            return hash<uint64_t>()(static_cast<uint64_t>(handle.generation) << 32 | handle.index);
+        }
+    };
+}
+
+// Generational slot map : values are stored contiguously and resolved by an index plus a generation check.
+// Erase moves the last value into the erased place, so dense indices are not stable but handles are.
+template <typename T, typename Tag = T>
+class SlotMap
+{
+public:
+    using Handle = SlotHandle<Tag>;
+
+    Handle Insert(T value)
+    {
+        uint32_t slotIndex;
+        if (!m_freeSlots.empty())
+        {
+            slotIndex = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else
+        {
+            slotIndex = static_cast<uint32_t>(m_slots.size());
+            m_slots.emplace_back();
+        }
+
+        Slot& slot = m_slots[slotIndex];
+        slot.denseIndex = static_cast<uint32_t>(m_values.size());
+        m_values.push_back(std::move(value));
+        m_denseToSlot.push_back(slotIndex);
+
+        return { slotIndex, slot.generation };
+    }
+
+    // Returns false if the handle is stale
+    bool Erase(const Handle& handle)
+    {
+        if (!Contains(handle))
+            return false;
+
+        Slot& slot = m_slots[handle.index];
+        const uint32_t denseIndex = slot.denseIndex;
+        const uint32_t lastIndex = static_cast<uint32_t>(m_values.size() - 1);
+        if (denseIndex != lastIndex)
+        {
+            m_values[denseIndex] = std::move(m_values[lastIndex]);
+            m_denseToSlot[denseIndex] = m_denseToSlot[lastIndex];
+            m_slots[m_denseToSlot[denseIndex]].denseIndex = denseIndex;
+        }
+        m_values.pop_back();
+        m_denseToSlot.pop_back();
+
+        slot.denseIndex = UINT32_MAX;
+        slot.generation++;
+        m_freeSlots.push_back(handle.index);
+        return true;
+    }
+
+    bool Contains(const Handle& handle) const
+    {
+        return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation
+            && m_slots[handle.index].denseIndex != UINT32_MAX;
+    }
+
+    T* Get(const Handle& handle)
+    {
+        return Contains(handle) ? &m_values[m_slots[handle.index].denseIndex] : nullptr;
+    }
+
+    const T* Get(const Handle& handle) const
+    {
+        return Contains(handle) ? &m_values[m_slots[handle.index].denseIndex] : nullptr;
+    }
+
+    // Index of the value inside the dense array, UINT32_MAX if the handle is stale
+    uint32_t GetDenseIndex(const Handle& handle) const
+    {
+        return Contains(handle) ? m_slots[handle.index].denseIndex : UINT32_MAX;
+    }
+
+    Handle GetHandle(uint32_t denseIndex) const
+    {
+        const uint32_t slotIndex = m_denseToSlot[denseIndex];
+        return { slotIndex, m_slots[slotIndex].generation };
+    }
+
+    void Clear()
+    {
+        for (uint32_t slotIndex : m_denseToSlot)
+        {
+            m_slots[slotIndex].denseIndex = UINT32_MAX;
+            m_slots[slotIndex].generation++;
+            m_freeSlots.push_back(slotIndex);
+        }
+        m_values.clear();
+        m_denseToSlot.clear();
+    }
+
+    size_t Size() const { return m_values.size(); }
+    bool Empty() const { return m_values.empty(); }
+
+    std::vector<T>& GetValues() { return m_values; }
+    const std::vector<T>& GetValues() const { return m_values; }
+
+private:
+    struct Slot
+    {
+        uint32_t denseIndex = UINT32_MAX;
+        uint32_t generation = 0;
+    };
+
+    std::vector<T> m_values;
+    std::vector<uint32_t> m_denseToSlot;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+};
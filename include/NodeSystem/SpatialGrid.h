@@ -0,0 +1,194 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <galaxymath/Maths.h>
+
+using namespace GALAXY;
+
+// Uniform grid over grid space bounds, used to only visit the elements near a point or a rectangle.
+// An element is stored in every cell overlapped by its bounds.
+template <typename Handle>
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(float cellSize = 256.f) : m_cellSize(cellSize) {}
+
+    // Insert the element or move it to its new bounds
+    void Set(const Handle& handle, const Vec2f& min, const Vec2f& max)
+    {
+        const Bounds bounds = { min, max };
+        auto it = m_bounds.find(handle);
+        if (it == m_bounds.end())
+        {
+            m_bounds.emplace(handle, bounds);
+            AddToCells(handle, bounds);
+            return;
+        }
+
+        const CellRange previousRange = GetCellRange(it->second.min, it->second.max);
+        const CellRange range = GetCellRange(min, max);
+        it->second = bounds;
+        if (previousRange == range)
+        {
+            // Same cells, only update the stored bounds
+            ForEachCell(range, [&](Cell& cell)
+            {
+                FindItem(cell, handle)->bounds = bounds;
+            });
+            return;
+        }
+        RemoveFromCells(handle, previousRange);
+        AddToCells(handle, bounds);
+    }
+
+    void Remove(const Handle& handle)
+    {
+        auto it = m_bounds.find(handle);
+        if (it == m_bounds.end())
+            return;
+        RemoveFromCells(handle, GetCellRange(it->second.min, it->second.max));
+        m_bounds.erase(it);
+    }
+
+    void Clear()
+    {
+        m_cells.clear();
+        m_bounds.clear();
+    }
+
+    // Append every element whose bounds overlap the rectangle, each element once
+    void Query(const Vec2f& min, const Vec2f& max, std::vector<Handle>& result) const
+    {
+        const CellRange range = GetCellRange(min, max);
+
+        // Zoomed out far enough, visiting the cells would cost more than testing everything
+        if (range.Count() > m_bounds.size())
+        {
+            for (const auto& [handle, bounds] : m_bounds)
+            {
+                if (bounds.Overlaps(min, max))
+                    result.push_back(handle);
+            }
+            return;
+        }
+
+        for (int32_t y = range.minY; y <= range.maxY; y++)
+        {
+            for (int32_t x = range.minX; x <= range.maxX; x++)
+            {
+                auto it = m_cells.find(GetKey(x, y));
+                if (it == m_cells.end())
+                    continue;
+                for (const Item& item : it->second)
+                {
+                    if (!item.bounds.Overlaps(min, max))
+                        continue;
+                    // Only report the element from the first cell it shares with the query
+                    const CellRange itemRange = GetCellRange(item.bounds.min, item.bounds.max);
+                    if (x != std::max(itemRange.minX, range.minX) || y != std::max(itemRange.minY, range.minY))
+                        continue;
+                    result.push_back(item.handle);
+                }
+            }
+        }
+    }
+
+    size_t Size() const { return m_bounds.size(); }
+
+private:
+    struct Bounds
+    {
+        Vec2f min;
+        Vec2f max;
+
+        bool Overlaps(const Vec2f& otherMin, const Vec2f& otherMax) const
+        {
+            return max.x >= otherMin.x && min.x <= otherMax.x && max.y >= otherMin.y && min.y <= otherMax.y;
+        }
+    };
+
+    struct Item
+    {
+        Handle handle;
+        Bounds bounds;
+    };
+    using Cell = std::vector<Item>;
+
+    struct CellRange
+    {
+        int32_t minX, minY, maxX, maxY;
+
+        uint64_t Count() const { return static_cast<uint64_t>(maxX - minX + 1) * static_cast<uint64_t>(maxY - minY + 1); }
+        bool operator==(const CellRange& other) const = default;
+    };
+
+    static uint64_t GetKey(int32_t x, int32_t y)
+    {
+        return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+    }
+
+    int32_t GetCellCoord(float value) const
+    {
+        return static_cast<int32_t>(std::floor(value / m_cellSize));
+    }
+
+    CellRange GetCellRange(const Vec2f& min, const Vec2f& max) const
+    {
+        return { GetCellCoord(min.x), GetCellCoord(min.y), GetCellCoord(max.x), GetCellCoord(max.y) };
+    }
+
+    template <typename Func>
+    void ForEachCell(const CellRange& range, Func&& func)
+    {
+        for (int32_t y = range.minY; y <= range.maxY; y++)
+        {
+            for (int32_t x = range.minX; x <= range.maxX; x++)
+            {
+                func(m_cells[GetKey(x, y)]);
+            }
+        }
+    }
+
+    static Item* FindItem(Cell& cell, const Handle& handle)
+    {
+        auto it = std::ranges::find_if(cell, [&](const Item& item) { return item.handle == handle; });
+        return it != cell.end() ? &*it : nullptr;
+    }
+
+    void AddToCells(const Handle& handle, const Bounds& bounds)
+    {
+        ForEachCell(GetCellRange(bounds.min, bounds.max), [&](Cell& cell)
+        {
+            cell.push_back({ handle, bounds });
+        });
+    }
+
+    void RemoveFromCells(const Handle& handle, const CellRange& range)
+    {
+        for (int32_t y = range.minY; y <= range.maxY; y++)
+        {
+            for (int32_t x = range.minX; x <= range.maxX; x++)
+            {
+                auto it = m_cells.find(GetKey(x, y));
+                if (it == m_cells.end())
+                    continue;
+                Cell& cell = it->second;
+                if (Item* item = FindItem(cell, handle))
+                {
+                    *item = cell.back();
+                    cell.pop_back();
+                }
+                if (cell.empty())
+                    m_cells.erase(it);
+            }
+        }
+    }
+
+private:
+    float m_cellSize;
+    std::unordered_map<uint64_t, Cell> m_cells;
+    std::unordered_map<Handle, Bounds> m_bounds;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "UUID.h"
+
+// Topological order of the linked nodes kept up to date on each new edge (Pearce-Kelly dynamic topological sort).
+// An edge goes from the node of the output to the node of the input, so a node is always placed before the nodes it feeds.
+// Only the nodes between the two ends of a misplaced edge are visited, an edge already in order costs O(1).
+class TopologicalOrder
+{
+public:
+    // Returns false and leaves the order untouched if the edge would close a cycle
+    bool AddEdge(const UUID& from, const UUID& to);
+    // Removing an edge never breaks the order, only the adjacency is updated
+    void RemoveEdge(const UUID& from, const UUID& to);
+    void RemoveNode(const UUID& node);
+    void Clear();
+
+    bool WouldCreateCycle(const UUID& from, const UUID& to) const;
+
+    bool Contains(const UUID& node) const { return m_entries.contains(node); }
+    // Position in the order, only meaningful compared to the position of another node
+    uint32_t GetPosition(const UUID& node) const { return m_entries.at(node).position; }
+
+    // Set result to the nodes with a path to the node followed by the node itself, in order
+    void GetUpstream(const UUID& node, std::vector<UUID>& result) const;
+
+    // Call the function on each node in order, sources first
+    template <typename Func>
+    void ForEach(Func&& func) const
+    {
+        for (const UUID& node : m_positionToNode)
+        {
+            if (node != UUID_NULL)
+                func(node);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t position = 0;
+        std::vector<UUID> successors; // One per edge, a pair of nodes can be linked several times
+        std::vector<UUID> predecessors;
+    };
+
+    Entry& GetOrCreateEntry(const UUID& node);
+    // Nodes reachable from start whose position is lower or equal to upperBound, false if target is reached
+    bool SearchForward(const UUID& start, uint32_t upperBound, const UUID& target, std::vector<UUID>& visited) const;
+    // Nodes reaching start whose position is greater or equal to lowerBound
+    void SearchBackward(const UUID& start, uint32_t lowerBound, std::vector<UUID>& visited) const;
+    void Compact();
+
+private:
+    std::unordered_map<UUID, Entry> m_entries;
+    std::vector<UUID> m_positionToNode; // UUID_NULL where a node was removed
+    uint32_t m_holeCount = 0;
+};
@@ -2,10 +2,12 @@
 #include <set>
 
 #include "NodeSystem/NodeManager.h"
+#include "NodeSystem/ShaderMaker.h"
 #include "Actions/Action.h"
 
 #define SAVE_FOLDER "saves/"
 #define EDITOR_FILE_NAME "editor.settings"
+#define PROGRAM_BINARY_FILE_NAME "programs.cache"
 #define TEMP_FOLDER "tmp/"
 
 #pragma region Dialog
@@ -59,10 +61,11 @@ public:
 
     Vec2f GetMousePosOnContext() const { return m_mousePosOnContext; }
 
-    void UpdateShader();
     void UpdateShaders();
 
     void ShouldUpdateShader() { m_shouldUpdateShader = true; }
+    // Unlinked inputs are uniforms, a value edit needs no new shader
+    bool UsesUniformInputs() const { return m_shaderMaker.GetUniformInputs(); }
     
     void AddPreviewNode(const UUID& uuid) { m_previewNodes.insert(uuid); }
     void RemovePreviewNode(const UUID& uuid) { m_previewNodes.erase(uuid); }
@@ -90,6 +93,8 @@ private:
     Ref<Shader> m_currentShader;
     Ref<Framebuffer> m_framebuffer;
     bool m_shouldUpdateShader = true;
+    // Kept between updates so unchanged nodes reuse their code
+    ShaderMaker m_shaderMaker;
 
     std::set<UUID> m_previewNodes;
 
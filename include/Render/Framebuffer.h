@@ -4,6 +4,9 @@
 #include <vector>
 #include <filesystem>
 
+#include "Render/ParameterBuffer.h"
+#include "Render/ProgramCache.h"
+
 template <typename T>
 using Ref = std::shared_ptr<T>;
 
@@ -38,11 +41,29 @@ private:
     uint32_t m_count;
 };
 
+struct Input;
+
+// Member of the parameter block set from the value of a node input each frame
+struct ShaderUniform
+{
+    std::string name;
+    std::weak_ptr<Input> input;
+    int32_t offset = -1; // In the parameter block, resolved when the program is used
+};
+
+enum class ShaderStatus
+{
+    Ready,
+    Compiling, // The previous program is still used
+    Linking,
+    Failed, // The previous program is still used
+};
+
 class Shader
 {
 public:
     Shader() = default;
-    ~Shader() = default;
+    ~Shader();
 
     bool LoadDefaultShader();
     bool LoadDefaultVertex();
@@ -53,18 +74,48 @@ public:
     bool SetFragmentShaderContent(const std::string& string);
     bool Link();
 
+    // Bind the program and the parameters written by UpdateValues
     void Use() const;
     bool RecompileFragmentShader();
     bool RecompileFragmentShader(const char* content);
-    void UpdateValues() const;
+    // Start compiling without waiting, the current program is used until UpdateCompilation finishes the new one.
+    // A source already linked by any shader reuses the program from the ProgramCache
+    void SubmitFragmentShader(const char* content, std::vector<ShaderUniform> uniforms = {});
+    // Move the compilation forward once the driver is done with the current step, never waits with
+    // GL_KHR_parallel_shader_compile. Returns true when the new program is used
+    bool UpdateCompilation();
+    // Write the values of the frame to the ParameterBuffer, every shader does it before the buffer is uploaded
+    void UpdateValues();
 
     bool IsLoaded() const { return m_loaded; }
+    ShaderStatus GetStatus() const { return m_status; }
+
+    // Let the driver compile on its own threads when GL_KHR_parallel_shader_compile is supported
+    static void InitializeParallelCompilation();
+
+private:
+    bool CheckLinkStatus(uint32_t program) const;
+    // wait : query the status even if the driver is not done
+    bool AdvanceCompilation(bool wait);
+    void UseProgram(ShaderProgramRef program);
 
 private:
     std::filesystem::path m_path;
     uint32_t m_program = -1;
-    uint32_t m_vertexShader = -1;
+    uint32_t m_vertexShader = -1; // Kept to link the programs of the next fragment shaders
     uint32_t m_fragmentShader = -1;
+    uint64_t m_vertexHash = 0;
+
+    ShaderProgramRef m_sharedProgram; // Program in use, from the cache or linked by Load, m_program is its ID
+    ShaderProgramRef m_pendingProgram; // Submitted, used once its link succeeds
+    uint32_t m_pendingFragmentShader = 0; // Submitted, not linked yet
+    std::string m_pendingContent;
+    std::vector<ShaderUniform> m_uniforms; // Of the program in use
+    std::vector<ShaderUniform> m_pendingUniforms;
+    ParameterRange m_parameters; // Of the current frame
+    ShaderStatus m_status = ShaderStatus::Ready;
+
+    static bool s_parallelCompilation;
 
     bool m_loaded = false;
 };
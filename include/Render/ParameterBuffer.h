@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Uniform blocks read by the generated shaders, GLSL 330 cannot give their binding so it is set on each program
+constexpr const char* c_globalsBlockName = "Globals";
+constexpr const char* c_parametersBlockName = "Parameters";
+constexpr uint32_t c_globalsBinding = 0;
+constexpr uint32_t c_parametersBinding = 1;
+
+// Part of the buffer holding the values of one shader for the current frame
+struct ParameterRange
+{
+    uint32_t offset = 0;
+    uint32_t size = 0;
+};
+
+// One std140 uniform buffer shared by every shader. The values of all the shaders are written
+// to their own range each frame then sent with a single upload, before any of them draws
+class ParameterBuffer
+{
+public:
+    static ParameterBuffer& GetInstance();
+
+    // Needs a current GL context
+    void Initialize();
+    void Destroy();
+
+    // Start the values of a new frame, the globals are at the start of the buffer
+    void BeginFrame(float time);
+    // The pointer of GetData is valid until the next allocation
+    ParameterRange Allocate(uint32_t size);
+    char* GetData(const ParameterRange& range) { return m_data.data() + range.offset; }
+    // Send every value written this frame and bind the globals
+    void Upload();
+
+    // Bind the parameters of the shader about to draw
+    void BindParameters(const ParameterRange& range) const;
+
+    uint32_t GetSize() const { return static_cast<uint32_t>(m_data.size()); }
+
+private:
+    uint32_t m_buffer = 0;
+    uint32_t m_bufferSize = 0;
+    uint32_t m_offsetAlignment = 256;
+    ParameterRange m_globals;
+    std::vector<char> m_data; // Capacity is kept between frames
+};
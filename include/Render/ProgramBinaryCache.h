@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Render/ProgramCache.h"
+
+// Linked program binaries saved between sessions, keyed like the ProgramCache.
+// The file is ignored when its version or the renderer and driver version changed,
+// the least recently used binaries are dropped past the size limit
+class ProgramBinaryCache
+{
+public:
+    static ProgramBinaryCache& GetInstance();
+
+    // Needs a current GL context, the cache stays disabled if the driver cannot give binaries
+    void Load(const std::filesystem::path& path);
+    void Save() const;
+
+    bool IsSupported() const { return m_supported; }
+
+    // Program created from the saved binary, nullptr if there is none or the driver refused it
+    ShaderProgramRef CreateProgram(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource);
+    // Keep the binary of a program that linked successfully
+    void Store(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource, uint32_t program);
+
+    void SetSizeLimit(size_t sizeLimit);
+    size_t GetSize() const { return m_size; }
+    uint64_t GetHitCount() const { return m_hitCount; }
+    uint64_t GetMissCount() const { return m_missCount; }
+
+private:
+    struct Entry
+    {
+        uint64_t key = 0;
+        uint64_t vertexHash = 0;
+        uint32_t format = 0;
+        std::string fragmentSource;
+        std::vector<char> binary;
+    };
+
+    static size_t GetEntrySize(const Entry& entry) { return entry.fragmentSource.size() + entry.binary.size(); }
+    std::list<Entry>::iterator Find(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource);
+    void Add(Entry&& entry);
+    void Erase(std::list<Entry>::iterator it);
+    void EvictUntil(size_t sizeLimit);
+
+    static uint64_t GetDeviceHash();
+
+private:
+    std::filesystem::path m_path;
+    bool m_supported = false;
+    bool m_dirty = false;
+
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_multimap<uint64_t, std::list<Entry>::iterator> m_index;
+
+    size_t m_sizeLimit = 32ull * 1024 * 1024;
+    size_t m_size = 0;
+    uint64_t m_hitCount = 0;
+    uint64_t m_missCount = 0;
+};
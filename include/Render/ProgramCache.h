@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Where a program reads its parameters, resolved once after its link
+struct ProgramLayout
+{
+    int32_t timeLocation = -1; // Plain uniform of the shaders loaded from files, the others read the globals block
+    uint32_t parametersSize = 0; // 0 without a parameter block
+    std::unordered_map<std::string, uint32_t> offsets; // Of each member of the parameter block
+};
+
+// Linked GL program, deleted with the last shader or cache entry using it
+class ShaderProgram
+{
+public:
+    ShaderProgram(uint32_t id, size_t size) : m_id(id), m_size(size) {}
+    ~ShaderProgram();
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    uint32_t GetID() const { return m_id; }
+    // Estimated memory held by the driver
+    size_t GetSize() const { return m_size; }
+
+    // Read the layout and set the block bindings, once the program is linked
+    void Reflect();
+    const ProgramLayout& GetLayout() const { return m_layout; }
+
+private:
+    uint32_t m_id;
+    size_t m_size;
+    ProgramLayout m_layout;
+};
+using ShaderProgramRef = std::shared_ptr<ShaderProgram>;
+
+// Linked programs keyed by a hash of their vertex and fragment sources, shared by every shader.
+// The least recently used programs are dropped past the memory cap, a shader still using one keeps it alive
+class ProgramCache
+{
+public:
+    static ProgramCache& GetInstance();
+
+    static uint64_t GetKey(uint64_t vertexHash, const std::string& fragmentSource);
+
+    // nullptr on a miss, the sources are compared so a hash collision is a miss
+    ShaderProgramRef Find(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource);
+    // Returns the program to use, the one already cached if the same sources were linked meanwhile
+    ShaderProgramRef Add(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource, const ShaderProgramRef& program);
+    // Drop every program, called before the GL context is destroyed
+    void Clear();
+
+    void SetMemoryCap(size_t memoryCap);
+    size_t GetMemoryCap() const { return m_memoryCap; }
+    size_t GetMemoryUsage() const { return m_memoryUsage; }
+    size_t GetProgramCount() const { return m_entries.size(); }
+    uint64_t GetHitCount() const { return m_hitCount; }
+    uint64_t GetMissCount() const { return m_missCount; }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        uint64_t vertexHash;
+        std::string fragmentSource;
+        ShaderProgramRef program;
+    };
+
+    static size_t GetEntrySize(const Entry& entry) { return entry.fragmentSource.size() + entry.program->GetSize(); }
+    void EvictUntil(size_t memoryCap);
+
+private:
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_multimap<uint64_t, std::list<Entry>::iterator> m_index;
+
+    size_t m_memoryCap = 64ull * 1024 * 1024;
+    size_t m_memoryUsage = 0;
+    uint64_t m_hitCount = 0;
+    uint64_t m_missCount = 0;
+};
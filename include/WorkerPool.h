@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept alive to run the iterations of a loop, the calling thread takes part and waits for the end.
+// Not reentrant : the function given to ParallelFor must not call it
+class WorkerPool
+{
+public:
+    explicit WorkerPool(uint32_t threadCount);
+    ~WorkerPool() = default;
+
+    // One thread per core, counting the calling thread
+    static WorkerPool& GetInstance();
+
+    // Call func once for each index in [0, count), in any order, returns once every call is done
+    void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_threads.size()) + 1; }
+
+private:
+    void WorkerLoop(const std::stop_token& stopToken);
+    void RunIterations();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable_any m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    const std::function<void(uint32_t)>* m_func = nullptr;
+    uint32_t m_count = 0;
+    std::atomic<uint32_t> m_nextIndex = 0;
+    uint32_t m_runningWorkers = 0;
+    uint64_t m_generation = 0; // Incremented for each loop, wakes the workers
+
+    // Last so the threads are joined before the rest is destroyed
+    std::vector<std::jthread> m_threads;
+};
@@ -25,10 +25,7 @@ void ActionManager::AddAction(const ActionRef& action)
     m_current->CleanRedoneActions();
     m_current->m_undoneActions.push_back(action);
 
-    if (auto nodeWindow = dynamic_cast<NodeWindow*>(m_current->m_context))
-    {
-        nodeWindow->ShouldUpdateShader();
-    }
+    m_current->OnActionApplied(*action);
 }
 
 void ActionManager::DoAction(const ActionRef& action)
@@ -45,10 +42,7 @@ void ActionManager::UndoLastAction()
         m_current->m_redoneActions.push_back(m_current->m_undoneActions.back());
         m_current->m_undoneActions.pop_back();
 
-        if (auto nodeWindow = dynamic_cast<NodeWindow*>(m_current->m_context))
-        {
-            nodeWindow->ShouldUpdateShader();
-        }
+        m_current->OnActionApplied(*m_current->m_redoneActions.back());
     }
 }
 
@@ -60,10 +54,7 @@ void ActionManager::RedoLastAction()
         m_current->m_undoneActions.push_back(m_current->m_redoneActions.back());
         m_current->m_redoneActions.pop_back();
         
-        if (auto nodeWindow = dynamic_cast<NodeWindow*>(m_current->m_context))
-        {
-            nodeWindow->ShouldUpdateShader();
-        }
+        m_current->OnActionApplied(*m_current->m_undoneActions.back());
     }
 }
 
@@ -77,6 +68,16 @@ void ActionManager::SetContext(Context* context)
     m_context = context;
 }
 
+void ActionManager::OnActionApplied(const Action& action) const
+{
+    if (auto nodeWindow = dynamic_cast<NodeWindow*>(m_context))
+    {
+        // Value edits are uploaded as uniforms, the shaders stay the same
+        if (!action.IsValueChange() || !nodeWindow->UsesUniformInputs())
+            nodeWindow->ShouldUpdateShader();
+    }
+}
+
 void ActionManager::CleanRedoneActions()
 {
     m_redoneActions.clear();
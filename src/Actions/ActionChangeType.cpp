@@ -5,28 +5,31 @@
 
 ActionChangeType::ActionChangeType(ParamNode* node, Type type, Type oldType): Action(), m_paramNode(node), m_type(type), m_oldType(oldType)
 {
-    auto links = m_paramNode->GetNodeManager()->GetLinkManager()->GetLinksWithOutput(m_paramNode->GetOutput(0));
+    auto linkManager = m_paramNode->GetNodeManager()->GetLinkManager();
+    auto links = linkManager->GetLinksWithOutput(m_paramNode->GetOutput(0));
     for (auto& link : links)
     {
-        m_link.push_back(*link.lock());
+        m_link.push_back(*linkManager->GetLink(link));
     }
 }
 
 ActionChangeType::ActionChangeType(CustomNode* node, InputRef input, Type type, Type oldType) : Action(), m_customNode(node), m_type(type), m_oldType(oldType), m_input(input)
 {
-    auto links = m_customNode->GetNodeManager()->GetLinkManager()->GetLinksWithInput(node->GetUUID(), input->index);
+    auto linkManager = m_customNode->GetNodeManager()->GetLinkManager();
+    auto links = linkManager->GetLinksWithInput(node->GetUUID(), input->index);
     for (auto& link : links)
     {
-        m_link.push_back(*link.lock());
+        m_link.push_back(*linkManager->GetLink(link));
     }
 }
 
 ActionChangeType::ActionChangeType(CustomNode* node, OutputRef output, Type type, Type oldType) : Action(), m_customNode(node), m_type(type), m_oldType(oldType), m_output(output)
 {
-    auto links = m_customNode->GetNodeManager()->GetLinkManager()->GetLinksWithOutput(output);
+    auto linkManager = m_customNode->GetNodeManager()->GetLinkManager();
+    auto links = linkManager->GetLinksWithOutput(output);
     for (auto& link : links)
     {
-        m_link.push_back(*link.lock());
+        m_link.push_back(*linkManager->GetLink(link));
     }
 }
 
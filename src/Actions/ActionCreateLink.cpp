@@ -1,6 +1,6 @@
 ﻿#include "Actions/ActionCreateLink.h"
 
-ActionCreateLink::ActionCreateLink(NodeManager* nodeManager, const LinkRef& link): m_nodeManager(nodeManager), m_link(link)
+ActionCreateLink::ActionCreateLink(NodeManager* nodeManager, const Link& link): m_nodeManager(nodeManager), m_link(link)
 {
     
 }
@@ -1,6 +1,6 @@
 ﻿#include "Actions/ActionDeleteNodesAndLinks.h"
 
-ActionDeleteNodesAndLinks::ActionDeleteNodesAndLinks(NodeManager* nodeManager, const std::vector<NodeWeak>& nodes, const std::vector<LinkWeakRef>& links)
+ActionDeleteNodesAndLinks::ActionDeleteNodesAndLinks(NodeManager* nodeManager, const std::vector<NodeWeak>& nodes, const std::vector<LinkHandle>& links)
 : m_nodeManager(nodeManager)
 {
     for (auto& node : nodes)
@@ -9,13 +9,14 @@ ActionDeleteNodesAndLinks::ActionDeleteNodesAndLinks(NodeManager* nodeManager, c
     }
     for (auto& link : links)
     {
-        m_links.push_back(link.lock());
+        if (const Link* linkPtr = nodeManager->GetLinkManager()->GetLink(link))
+            m_links.push_back(*linkPtr);
     }
 }
 
 void ActionDeleteNodesAndLinks::Do()
 {
-    for (LinkRef& link : m_links)
+    for (const Link& link : m_links)
     {
         m_nodeManager->GetLinkManager()->RemoveLink(link);
     }
@@ -27,7 +28,7 @@ void ActionDeleteNodesAndLinks::Do()
 
 void ActionDeleteNodesAndLinks::Undo()
 {
-    for (LinkRef& link : m_links)
+    for (const Link& link : m_links)
     {
         m_nodeManager->GetLinkManager()->AddLink(link);
     }
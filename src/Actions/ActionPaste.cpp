@@ -63,21 +63,21 @@ void ActionPaste::Do()
     // Adjust link references to new node UUIDs
     for (auto& link : data.links)
     {
-        if (uuidMap.contains(link->fromNodeIndex))
+        if (uuidMap.contains(link.fromNodeIndex))
         {
-            link->fromNodeIndex = uuidMap[link->fromNodeIndex];
+            link.fromNodeIndex = uuidMap[link.fromNodeIndex];
         }
         else
         {
-            std::cout << "Link from node not found: " << link->fromNodeIndex << std::endl;
+            std::cout << "Link from node not found: " << link.fromNodeIndex << std::endl;
         }
-        if (uuidMap.contains(link->toNodeIndex))
+        if (uuidMap.contains(link.toNodeIndex))
         {
-            link->toNodeIndex = uuidMap[link->toNodeIndex];
+            link.toNodeIndex = uuidMap[link.toNodeIndex];
         }
         else
         {
-            std::cout << "Link from node not found: " << link->fromNodeIndex << std::endl;
+            std::cout << "Link from node not found: " << link.fromNodeIndex << std::endl;
         }
             
         // Add link to link manager
@@ -5,6 +5,9 @@
 #include "NodeSystem/NodeTemplateHandler.h"
 #include "Render/Font.h"
 #include "Render/Framebuffer.h"
+#include "Render/ParameterBuffer.h"
+#include "Render/ProgramBinaryCache.h"
+#include "Render/ProgramCache.h"
 using namespace GALAXY;
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
@@ -105,6 +108,9 @@ void Application::Initialize()
         glDebugMessageCallback(glDebugOutput, nullptr);
         glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
     } 
+    Shader::InitializeParallelCompilation();
+    ParameterBuffer::GetInstance().Initialize();
+    ProgramBinaryCache::GetInstance().Load(PROGRAM_BINARY_FILE_NAME);
 
     const GLubyte* renderer = glGetString(GL_RENDERER);
     const GLubyte* version = glGetString(GL_VERSION);
@@ -190,6 +196,10 @@ void Application::Clean() const
     auto path = TEMP_FOLDER;
     std::filesystem::remove_all(path);
     m_nodeWindow.Delete();
+    ProgramBinaryCache::GetInstance().Save();
+    // Programs still used by a shader are deleted with it
+    ProgramCache::GetInstance().Clear();
+    ParameterBuffer::GetInstance().Destroy();
     
     // Cleanup
     ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,357 @@
+#include "NodeSystem/BezierKernel.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BEZIER_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr int c_maxDepth = 16;
+    constexpr float c_linearEpsilon = 1e-6f;
+
+    struct Bounds
+    {
+        float minX, minY, maxX, maxY;
+    };
+
+    // Range of one axis of a cubic, the extremities are the end points and the roots of the derivative
+    void CubicAxisRange(float p0, float p1, float p2, float p3, float& outMin, float& outMax)
+    {
+        outMin = std::min(p0, p3);
+        outMax = std::max(p0, p3);
+
+        const float a = p1 - p0;
+        const float b = p2 - p1;
+        const float c = p3 - p2;
+        const float qa = a - 2.f * b + c;
+        const float qb = 2.f * (b - a);
+
+        float roots[2];
+        int rootCount = 0;
+        if (std::abs(qa) < c_linearEpsilon)
+        {
+            if (std::abs(qb) > c_linearEpsilon)
+                roots[rootCount++] = -a / qb;
+        }
+        else
+        {
+            const float discriminant = qb * qb - 4.f * qa * a;
+            if (discriminant >= 0.f)
+            {
+                const float sqrtDiscriminant = std::sqrt(discriminant);
+                roots[rootCount++] = (-qb + sqrtDiscriminant) / (2.f * qa);
+                roots[rootCount++] = (-qb - sqrtDiscriminant) / (2.f * qa);
+            }
+        }
+
+        for (int i = 0; i < rootCount; i++)
+        {
+            const float t = roots[i];
+            if (t <= 0.f || t >= 1.f)
+                continue;
+            const float u = 1.f - t;
+            const float value = u * u * u * p0 + 3.f * u * u * t * p1 + 3.f * u * t * t * p2 + t * t * t * p3;
+            outMin = std::min(outMin, value);
+            outMax = std::max(outMax, value);
+        }
+    }
+
+    Bounds CurveBounds(const BezierBatch& batch, uint32_t i)
+    {
+        Bounds bounds;
+        CubicAxisRange(batch.p0x[i], batch.p1x[i], batch.p2x[i], batch.p3x[i], bounds.minX, bounds.maxX);
+        CubicAxisRange(batch.p0y[i], batch.p1y[i], batch.p2y[i], batch.p3y[i], bounds.minY, bounds.maxY);
+        return bounds;
+    }
+
+#ifdef BEZIER_KERNEL_SSE2
+    // Same as CubicAxisRange for 4 curves. Clamping the roots in [0, 1] keeps every evaluated value on the curve,
+    // so roots that do not exist only evaluate end points instead of needing a mask.
+    void CubicAxisRange4(__m128 p0, __m128 p1, __m128 p2, __m128 p3, __m128& outMin, __m128& outMax)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 two = _mm_set1_ps(2.f);
+        const __m128 three = _mm_set1_ps(3.f);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+        const __m128 a = _mm_sub_ps(p1, p0);
+        const __m128 b = _mm_sub_ps(p2, p1);
+        const __m128 c = _mm_sub_ps(p3, p2);
+        const __m128 qa = _mm_add_ps(_mm_sub_ps(a, _mm_mul_ps(two, b)), c);
+        const __m128 qb = _mm_mul_ps(two, _mm_sub_ps(b, a));
+
+        const __m128 discriminant = _mm_sub_ps(_mm_mul_ps(qb, qb), _mm_mul_ps(_mm_set1_ps(4.f), _mm_mul_ps(qa, a)));
+        const __m128 sqrtDiscriminant = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+        const __m128 inv2a = _mm_div_ps(one, _mm_mul_ps(two, qa));
+        const __m128 minusQb = _mm_sub_ps(zero, qb);
+        __m128 t1 = _mm_mul_ps(_mm_add_ps(minusQb, sqrtDiscriminant), inv2a);
+        __m128 t2 = _mm_mul_ps(_mm_sub_ps(minusQb, sqrtDiscriminant), inv2a);
+
+        // Nearly linear derivative
+        const __m128 isLinear = _mm_cmplt_ps(_mm_and_ps(qa, absMask), _mm_set1_ps(c_linearEpsilon));
+        const __m128 linearRoot = _mm_div_ps(_mm_sub_ps(zero, a), qb);
+        t1 = _mm_or_ps(_mm_and_ps(isLinear, linearRoot), _mm_andnot_ps(isLinear, t1));
+        t2 = _mm_or_ps(_mm_and_ps(isLinear, linearRoot), _mm_andnot_ps(isLinear, t2));
+
+        // _mm_max_ps returns the second operand for NaN
+        t1 = _mm_min_ps(_mm_max_ps(t1, zero), one);
+        t2 = _mm_min_ps(_mm_max_ps(t2, zero), one);
+
+        auto evaluate = [&](__m128 t)
+        {
+            const __m128 u = _mm_sub_ps(one, t);
+            const __m128 uu = _mm_mul_ps(u, u);
+            const __m128 tt = _mm_mul_ps(t, t);
+            __m128 value = _mm_mul_ps(_mm_mul_ps(uu, u), p0);
+            value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(three, _mm_mul_ps(uu, t)), p1));
+            value = _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(three, _mm_mul_ps(u, tt)), p2));
+            return _mm_add_ps(value, _mm_mul_ps(_mm_mul_ps(tt, t), p3));
+        };
+        const __m128 value1 = evaluate(t1);
+        const __m128 value2 = evaluate(t2);
+
+        outMin = _mm_min_ps(_mm_min_ps(p0, p3), _mm_min_ps(value1, value2));
+        outMax = _mm_max_ps(_mm_max_ps(p0, p3), _mm_max_ps(value1, value2));
+    }
+
+    // Calls func(index) for each curve whose exact bounds overlap the rectangle
+    template <typename Func>
+    void ForEachOverlappingCurve(const BezierBatch& batch, float minX, float minY, float maxX, float maxY, Func&& func)
+    {
+        const uint32_t size = batch.Size();
+        const __m128 rectMinX = _mm_set1_ps(minX);
+        const __m128 rectMinY = _mm_set1_ps(minY);
+        const __m128 rectMaxX = _mm_set1_ps(maxX);
+        const __m128 rectMaxY = _mm_set1_ps(maxY);
+
+        uint32_t i = 0;
+        for (; i + 4 <= size; i += 4)
+        {
+            __m128 curveMinX, curveMaxX, curveMinY, curveMaxY;
+            CubicAxisRange4(_mm_loadu_ps(&batch.p0x[i]), _mm_loadu_ps(&batch.p1x[i]), _mm_loadu_ps(&batch.p2x[i]), _mm_loadu_ps(&batch.p3x[i]), curveMinX, curveMaxX);
+            CubicAxisRange4(_mm_loadu_ps(&batch.p0y[i]), _mm_loadu_ps(&batch.p1y[i]), _mm_loadu_ps(&batch.p2y[i]), _mm_loadu_ps(&batch.p3y[i]), curveMinY, curveMaxY);
+
+            const __m128 overlap = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(curveMinX, rectMaxX), _mm_cmpge_ps(curveMaxX, rectMinX)),
+                                              _mm_and_ps(_mm_cmple_ps(curveMinY, rectMaxY), _mm_cmpge_ps(curveMaxY, rectMinY)));
+            int laneMask = _mm_movemask_ps(overlap);
+            while (laneMask)
+            {
+                const int lane = std::countr_zero(static_cast<unsigned>(laneMask));
+                laneMask &= laneMask - 1;
+                if (func(i + lane))
+                    return;
+            }
+        }
+
+        for (; i < size; i++)
+        {
+            const Bounds bounds = CurveBounds(batch, i);
+            if (bounds.minX <= maxX && bounds.maxX >= minX && bounds.minY <= maxY && bounds.maxY >= minY && func(i))
+                return;
+        }
+    }
+#else
+    template <typename Func>
+    void ForEachOverlappingCurve(const BezierBatch& batch, float minX, float minY, float maxX, float maxY, Func&& func)
+    {
+        for (uint32_t i = 0; i < batch.Size(); i++)
+        {
+            const Bounds bounds = CurveBounds(batch, i);
+            if (bounds.minX <= maxX && bounds.maxX >= minX && bounds.minY <= maxY && bounds.maxY >= minY && func(i))
+                return;
+        }
+    }
+#endif
+
+    void LoadCurve(const BezierBatch& batch, uint32_t i, Vec2f controlPoints[4])
+    {
+        controlPoints[0] = Vec2f(batch.p0x[i], batch.p0y[i]);
+        controlPoints[1] = Vec2f(batch.p1x[i], batch.p1y[i]);
+        controlPoints[2] = Vec2f(batch.p2x[i], batch.p2y[i]);
+        controlPoints[3] = Vec2f(batch.p3x[i], batch.p3y[i]);
+    }
+
+    Bounds HullBounds(const Vec2f controlPoints[4])
+    {
+        Bounds bounds = { controlPoints[0].x, controlPoints[0].y, controlPoints[0].x, controlPoints[0].y };
+        for (int i = 1; i < 4; i++)
+        {
+            bounds.minX = std::min(bounds.minX, controlPoints[i].x);
+            bounds.minY = std::min(bounds.minY, controlPoints[i].y);
+            bounds.maxX = std::max(bounds.maxX, controlPoints[i].x);
+            bounds.maxY = std::max(bounds.maxY, controlPoints[i].y);
+        }
+        return bounds;
+    }
+
+    // The curve is flat enough when its control points are within tolerance of the chord
+    bool IsFlat(const Vec2f controlPoints[4], float tolerance)
+    {
+        const float ux = 3.f * controlPoints[1].x - 2.f * controlPoints[0].x - controlPoints[3].x;
+        const float uy = 3.f * controlPoints[1].y - 2.f * controlPoints[0].y - controlPoints[3].y;
+        const float vx = 3.f * controlPoints[2].x - controlPoints[0].x - 2.f * controlPoints[3].x;
+        const float vy = 3.f * controlPoints[2].y - controlPoints[0].y - 2.f * controlPoints[3].y;
+        return std::max(ux * ux, vx * vx) + std::max(uy * uy, vy * vy) <= 16.f * tolerance * tolerance;
+    }
+
+    // De Casteljau split at t = 0.5
+    void Split(const Vec2f controlPoints[4], Vec2f left[4], Vec2f right[4])
+    {
+        const Vec2f p01 = (controlPoints[0] + controlPoints[1]) * 0.5f;
+        const Vec2f p12 = (controlPoints[1] + controlPoints[2]) * 0.5f;
+        const Vec2f p23 = (controlPoints[2] + controlPoints[3]) * 0.5f;
+        const Vec2f p012 = (p01 + p12) * 0.5f;
+        const Vec2f p123 = (p12 + p23) * 0.5f;
+        const Vec2f middle = (p012 + p123) * 0.5f;
+
+        left[0] = controlPoints[0];
+        left[1] = p01;
+        left[2] = p012;
+        left[3] = middle;
+        right[0] = middle;
+        right[1] = p123;
+        right[2] = p23;
+        right[3] = controlPoints[3];
+    }
+
+    float SegmentDistanceSq(const Vec2f& point, const Vec2f& start, const Vec2f& end)
+    {
+        const Vec2f segment = end - start;
+        const Vec2f pointVec = point - start;
+        const float lengthSq = segment.x * segment.x + segment.y * segment.y;
+        const float t = lengthSq > 0.f ? std::clamp((pointVec.x * segment.x + pointVec.y * segment.y) / lengthSq, 0.f, 1.f) : 0.f;
+        const float dx = pointVec.x - segment.x * t;
+        const float dy = pointVec.y - segment.y * t;
+        return dx * dx + dy * dy;
+    }
+
+    bool IsInside(const Vec2f& point, const Vec2f& rectMin, const Vec2f& rectMax)
+    {
+        return point.x >= rectMin.x && point.x <= rectMax.x && point.y >= rectMin.y && point.y <= rectMax.y;
+    }
+
+    // Liang-Barsky clipping of the segment against the rectangle
+    bool SegmentIntersectsRect(const Vec2f& start, const Vec2f& end, const Vec2f& rectMin, const Vec2f& rectMax)
+    {
+        float tMin = 0.f;
+        float tMax = 1.f;
+        const float delta[2] = { end.x - start.x, end.y - start.y };
+        const float startValue[2] = { start.x, start.y };
+        const float minValue[2] = { rectMin.x, rectMin.y };
+        const float maxValue[2] = { rectMax.x, rectMax.y };
+        for (int axis = 0; axis < 2; axis++)
+        {
+            if (delta[axis] == 0.f)
+            {
+                if (startValue[axis] < minValue[axis] || startValue[axis] > maxValue[axis])
+                    return false;
+                continue;
+            }
+            float t0 = (minValue[axis] - startValue[axis]) / delta[axis];
+            float t1 = (maxValue[axis] - startValue[axis]) / delta[axis];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+            if (tMin > tMax)
+                return false;
+        }
+        return true;
+    }
+
+    bool HitSubdivide(const Vec2f controlPoints[4], const Vec2f& point, float threshold, int depth)
+    {
+        const Bounds hull = HullBounds(controlPoints);
+        if (point.x < hull.minX - threshold || point.x > hull.maxX + threshold
+            || point.y < hull.minY - threshold || point.y > hull.maxY + threshold)
+            return false;
+
+        if (depth >= c_maxDepth || IsFlat(controlPoints, threshold * 0.02f))
+            return SegmentDistanceSq(point, controlPoints[0], controlPoints[3]) <= threshold * threshold;
+
+        Vec2f left[4], right[4];
+        Split(controlPoints, left, right);
+        return HitSubdivide(left, point, threshold, depth + 1) || HitSubdivide(right, point, threshold, depth + 1);
+    }
+
+    bool RectSubdivide(const Vec2f controlPoints[4], const Vec2f& rectMin, const Vec2f& rectMax, float tolerance, int depth)
+    {
+        const Bounds hull = HullBounds(controlPoints);
+        if (hull.maxX < rectMin.x || hull.minX > rectMax.x || hull.maxY < rectMin.y || hull.minY > rectMax.y)
+            return false;
+        // The curve is inside its hull
+        if (hull.minX >= rectMin.x && hull.maxX <= rectMax.x && hull.minY >= rectMin.y && hull.maxY <= rectMax.y)
+            return true;
+        if (IsInside(controlPoints[0], rectMin, rectMax) || IsInside(controlPoints[3], rectMin, rectMax))
+            return true;
+
+        if (depth >= c_maxDepth || IsFlat(controlPoints, tolerance))
+            return SegmentIntersectsRect(controlPoints[0], controlPoints[3], rectMin, rectMax);
+
+        Vec2f left[4], right[4];
+        Split(controlPoints, left, right);
+        return RectSubdivide(left, rectMin, rectMax, tolerance, depth + 1) || RectSubdivide(right, rectMin, rectMax, tolerance, depth + 1);
+    }
+}
+
+void BezierBatch::Add(const Vec2f controlPoints[4])
+{
+    p0x.push_back(controlPoints[0].x);
+    p0y.push_back(controlPoints[0].y);
+    p1x.push_back(controlPoints[1].x);
+    p1y.push_back(controlPoints[1].y);
+    p2x.push_back(controlPoints[2].x);
+    p2y.push_back(controlPoints[2].y);
+    p3x.push_back(controlPoints[3].x);
+    p3y.push_back(controlPoints[3].y);
+}
+
+void BezierBatch::Clear()
+{
+    p0x.clear();
+    p0y.clear();
+    p1x.clear();
+    p1y.clear();
+    p2x.clear();
+    p2y.clear();
+    p3x.clear();
+    p3y.clear();
+}
+
+int32_t BezierKernel::FindHit(const BezierBatch& batch, const Vec2f& point, float threshold)
+{
+    int32_t hitIndex = -1;
+    ForEachOverlappingCurve(batch, point.x - threshold, point.y - threshold, point.x + threshold, point.y + threshold,
+        [&](uint32_t i)
+        {
+            Vec2f controlPoints[4];
+            LoadCurve(batch, i, controlPoints);
+            if (!HitSubdivide(controlPoints, point, threshold, 0))
+                return false;
+            hitIndex = static_cast<int32_t>(i);
+            return true;
+        });
+    return hitIndex;
+}
+
+void BezierKernel::IntersectRect(const BezierBatch& batch, const Vec2f& rectMin, const Vec2f& rectMax, std::vector<uint64_t>& mask)
+{
+    mask.assign((batch.Size() + 63) / 64, 0);
+    // Flatness tolerance relative to the rectangle, a curve closer than that to its border can go either way
+    const float tolerance = std::max(1e-3f, std::min(rectMax.x - rectMin.x, rectMax.y - rectMin.y) * 0.01f);
+    ForEachOverlappingCurve(batch, rectMin.x, rectMin.y, rectMax.x, rectMax.y,
+        [&](uint32_t i)
+        {
+            Vec2f controlPoints[4];
+            LoadCurve(batch, i, controlPoints);
+            if (RectSubdivide(controlPoints, rectMin, rectMax, tolerance, 0))
+                mask[i / 64] |= uint64_t(1) << (i % 64);
+            return false;
+        });
+}
@@ -347,62 +347,6 @@ std::vector<std::string> CustomNode::GetFormatStrings() const
     return formatStrings;
 }
 
-std::string CustomNode::ToShader(ShaderMaker* shaderMaker, const FuncStruct& funcStruct) const
-{
-    std::string content;
-    auto& variableNames = shaderMaker->m_variablesNames;
-    auto& allVariableNames = shaderMaker->m_allVariableNames;
-    auto toFormatList = GetFormatStrings();
-    for (int k = 0; k < p_outputs.size(); k++)
-    {
-        std::string variableName = funcStruct.outputs[k];
-        std::string glslType = ShaderMaker::TypeToGLSLType(p_outputs[k]->type);
-
-        if (allVariableNames.contains(variableName))
-            continue;
-        allVariableNames.insert(variableName);
-        std::string thisContent = glslType + " " + variableName + ";\n";
-        content += thisContent;
-    }
-        
-    std::string toFormat = toFormatList[0];
-    std::string secondHalf = toFormat;
-    toFormat.clear();
-    for (int j = 0; j < p_inputs.size(); j++)
-    {
-        InputRef input = p_inputs[j];
-        size_t index = secondHalf.find_first_of("%") + 2;
-        if (index == std::string::npos)
-            break;
-        std::string firstHalf = secondHalf.substr(0, index);
-        if (index != std::string::npos)
-            secondHalf = secondHalf.substr(index);
-        if (!input->isLinked)
-        {
-            variableNames.push_back(ShaderMaker::GetValueAsString(input));
-        }
-        auto parentVariableName = funcStruct.inputs[j];
-        if (parentVariableName.empty())
-            parentVariableName = variableNames.back();
-        toFormat += FormatString(firstHalf, parentVariableName.c_str());
-    }
-    for (int j = 0; j < p_outputs.size(); j++)
-    {
-        OutputRef output = p_outputs[j];
-        size_t index = secondHalf.find_first_of("%") + 2;
-        if (index == std::string::npos)
-            break;
-        std::string firstHalf = secondHalf.substr(0, index);
-        if (index != std::string::npos)
-            secondHalf = secondHalf.substr(index);
-        auto parentVariableName = funcStruct.outputs[j];
-        toFormat += FormatString(firstHalf, parentVariableName.c_str());
-    }
-    content += toFormat + secondHalf + ";\n";
-    
-    return content;
-}
-
 void CustomNode::ClearInputs()
 {
     for (int i = 0; i < p_inputs.size(); i++)
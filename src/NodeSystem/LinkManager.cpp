@@ -3,7 +3,12 @@
 #include <CppSerializer.h>
 #include <utility>
 
+#include "NodeSystem/BezierKernel.h"
 #include "NodeSystem/NodeManager.h"
+
+// Distance to a link that still picks it, 3 pixels at zoom 1 so 3 in grid space
+constexpr float c_linkPickThreshold = 3.f;
+
 namespace Utils
 {
     // Utility function to get a point on a cubic Bezier curve for a given t (0 <= t <= 1)
@@ -22,48 +27,6 @@ namespace Utils
 
         return point;
     }
-
-    // Helper function to check if a line segment intersects the rectangle
-    bool LineIntersectsRect(const Vec2f& start, const Vec2f& end, const Vec2f& rectMin, const Vec2f& rectMax)
-    {
-        // Check if either endpoint is inside the rectangle
-        if ((rectMin.x <= start.x && start.x <= rectMax.x && rectMin.y <= start.y && start.y <= rectMax.y) ||
-            (rectMin.x <= end.x && end.x <= rectMax.x && rectMin.y <= end.y && end.y <= rectMax.y))
-        {
-            return true;
-        }
-
-        float dx = end.x - start.x;
-        float dy = end.y - start.y;
-
-        // Check for intersection with each edge of the rectangle
-        if (dx != 0) {
-            float t1 = (rectMin.x - start.x) / dx;
-            float t2 = (rectMax.x - start.x) / dx;
-            if (0 <= t1 && t1 <= 1) {
-                float y = start.y + t1 * dy;
-                if (rectMin.y <= y && y <= rectMax.y) return true;
-            }
-            if (0 <= t2 && t2 <= 1) {
-                float y = start.y + t2 * dy;
-                if (rectMin.y <= y && y <= rectMax.y) return true;
-            }
-        }
-        if (dy != 0) {
-            float t1 = (rectMin.y - start.y) / dy;
-            float t2 = (rectMax.y - start.y) / dy;
-            if (0 <= t1 && t1 <= 1) {
-                float x = start.x + t1 * dx;
-                if (rectMin.x <= x && x <= rectMax.x) return true;
-            }
-            if (0 <= t2 && t2 <= 1) {
-                float x = start.x + t2 * dx;
-                if (rectMin.x <= x && x <= rectMax.x) return true;
-            }
-        }
-
-        return false;
-    }
 }
 
 void LinkManager::UpdateLinkSelection(const Vec2f& origin, float zoom)
@@ -71,7 +34,8 @@ void LinkManager::UpdateLinkSelection(const Vec2f& origin, float zoom)
     UserInputState userInputState = m_nodeManager->GetUserInputState();
     if (userInputState == UserInputState::None && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
     {
-        if (auto clickedLink = GetLinkClicked(zoom, origin, ImGui::GetMousePos()).lock())
+        LinkHandle clickedLink = GetLinkClicked(zoom, origin, ImGui::GetMousePos());
+        if (clickedLink.IsValid())
         {
             AddSelectedLink(clickedLink);
         }
@@ -84,36 +48,50 @@ void LinkManager::UpdateLinkSelection(const Vec2f& origin, float zoom)
 
     ClearSelectedLinks();
 
-    for (const LinkRef& link : m_links)
+    // The square can be drawn in any direction
+    const Vec2f squareMin(std::min(selectionSquare.min.x, selectionSquare.max.x), std::min(selectionSquare.min.y, selectionSquare.max.y));
+    const Vec2f squareMax(std::max(selectionSquare.min.x, selectionSquare.max.x), std::max(selectionSquare.min.y, selectionSquare.max.y));
+
+    const Vec2f gridSquareMin = NodeManager::ToGrid(squareMin, zoom, origin);
+    const Vec2f gridSquareMax = NodeManager::ToGrid(squareMax, zoom, origin);
+
+    std::vector<LinkHandle> candidates;
+    m_linkGrid.Query(gridSquareMin, gridSquareMax, candidates);
+
+    // check which links are inside the selection square
+    m_linkBatch.Clear();
+    for (const LinkHandle& link : candidates)
+    {
+        m_linkBatch.Add(GetLinkCurve(link)->controlPoints);
+    }
+    BezierKernel::IntersectRect(m_linkBatch, gridSquareMin, gridSquareMax, m_selectionMask);
+    for (uint32_t i = 0; i < candidates.size(); i++)
     {
-        // check if the link is inside the selection square
-        Vec2f positionIn = m_nodeManager->GetNode(link->fromNodeIndex).lock()->GetOutputPosition(link->fromOutputIndex, origin, zoom);
-        Vec2f positionOut = m_nodeManager->GetNode(link->toNodeIndex).lock()->GetInputPosition(link->toInputIndex, origin, zoom);
-        if (BezierIntersectSquare(positionIn, positionIn + Vec2f(m_controlDistanceX, 0.0f) * zoom,
-                                  positionOut - Vec2f(m_controlDistanceX, 0.0f) * zoom, positionOut,
-                                  selectionSquare.min, selectionSquare.max))
+        if (BezierKernel::IsSet(m_selectionMask, i))
         {
-            m_selectedLinks.push_back(link);
+            m_selectedLinks.push_back(candidates[i]);
         }
     }
 }
 
 void LinkManager::UpdateInputOutputLinks()
 {
-    for (int i = 0; i < m_links.size(); i++)
+    for (uint32_t i = 0; i < m_links.Size();)
     {
-        auto& link = m_links[i];
-        if (!m_nodeManager->NodeExists(link->toNodeIndex) || !m_nodeManager->NodeExists(link->fromNodeIndex))
+        const Link& link = m_links.GetValues()[i];
+        if (!m_nodeManager->NodeExists(link.toNodeIndex) || !m_nodeManager->NodeExists(link.fromNodeIndex))
         {
-            RemoveLink(i--, false);
+            // The last link is moved to this index
+            RemoveLink(m_links.GetHandle(i), false);
             continue;
         }
-        InputRef input = m_nodeManager->GetInput(link->toNodeIndex, link->toInputIndex).lock();
-        OutputRef output = m_nodeManager->GetOutput(link->fromNodeIndex, link->fromOutputIndex).lock();
+        InputRef input = m_nodeManager->GetInput(link.toNodeIndex, link.toInputIndex).lock();
+        OutputRef output = m_nodeManager->GetOutput(link.fromNodeIndex, link.fromOutputIndex).lock();
         if (input)
             input->SetLinked(output != nullptr);
         if (output)
             output->SetLinked(input != nullptr);
+        i++;
     }
 }
 
@@ -121,62 +99,40 @@ void LinkManager::DrawLinks(float zoom, const Vec2f& origin)
 {
     auto drawList = ImGui::GetWindowDrawList();
 
-    for (uint32_t i = 0; i < m_selectedLinks.size(); i++)
+    std::erase_if(m_selectedLinks, [this](const LinkHandle& link) { return !m_links.Contains(link); });
+    for (const LinkHandle& selectedLink : m_selectedLinks)
     {
-        if (!m_selectedLinks[i].lock())
+        if (const LinkCurve* curve = GetLinkCurve(selectedLink))
         {
-            m_selectedLinks.erase(m_selectedLinks.begin() + i);
-            i--;
-            continue;
-        }
-        LinkRef selectedLink = m_selectedLinks[i].lock();
-        NodeRef fromNode = m_nodeManager->GetNode(selectedLink->fromNodeIndex).lock();
-        NodeRef toNode = m_nodeManager->GetNode(selectedLink->toNodeIndex).lock();
-
-        if (!fromNode || !toNode)
-        {
-            m_selectedLinks.erase(m_selectedLinks.begin() + i);
-            i--;
-            continue;
+            DrawLinkCurve(drawList, *curve, zoom, origin, IM_COL32(255, 255, 0, 255), 3 * zoom);
         }
-        
-        assert(toNode != nullptr && fromNode != nullptr && "Node not found");
-        
-        Vec2f inputPosition = fromNode->GetOutputPosition(selectedLink->fromOutputIndex, origin, zoom);
-        Vec2f outputPosition = toNode->GetInputPosition(selectedLink->toInputIndex, origin, zoom);
-        
-        Vec2f controlPoint1 = inputPosition + Vec2f(m_controlDistanceX, 0.0f) * zoom;
-        Vec2f controlPoint2 = outputPosition - Vec2f(m_controlDistanceX, 0.0f) * zoom;
-        
-        drawList->AddBezierCubic(inputPosition, controlPoint1, controlPoint2, outputPosition, IM_COL32(255, 255, 0, 255), 3 * zoom, m_bezierSegmentCount);
     }
-    
-    for (uint32_t i = 0; i < m_links.size(); i++)
+
+    // Only the curves overlapping the window are drawn
+    const Vec2f windowPos = ImGui::GetWindowPos();
+    std::vector<LinkHandle> visibleLinks;
+    m_linkGrid.Query(NodeManager::ToGrid(windowPos, zoom, origin), NodeManager::ToGrid(windowPos + Vec2f(ImGui::GetWindowSize()), zoom, origin), visibleLinks);
+    for (const LinkHandle& link : visibleLinks)
     {
-        LinkRef link = m_links[i];
-        NodeRef fromNode = m_nodeManager->GetNode(link->fromNodeIndex).lock();
-        NodeRef toNode = m_nodeManager->GetNode(link->toNodeIndex).lock();
-        
-        if (!fromNode || !toNode)
-        {
-            RemoveLink(i);
-            i--;
+        const LinkCurve* curve = GetLinkCurve(link);
+        if (!curve)
             continue;
-        }
-        
-        assert(toNode != nullptr && fromNode != nullptr && "Node not found");
-        
-        Vec2f inputPosition = fromNode->GetOutputPosition(link->fromOutputIndex, origin, zoom);
-        Vec2f outputPosition = toNode->GetInputPosition(link->toInputIndex, origin, zoom);
-        
-        Vec2f controlPoint1 = inputPosition + Vec2f(m_controlDistanceX, 0.0f) * zoom;
-        Vec2f controlPoint2 = outputPosition - Vec2f(m_controlDistanceX, 0.0f) * zoom;
 
-        drawList->AddCircleFilled(inputPosition, 4.f * zoom, IM_COL32(255, 255, 255, 255));
-        drawList->AddCircleFilled(outputPosition, 4.f * zoom, IM_COL32(255, 255, 255, 255));
+        drawList->AddCircleFilled(NodeManager::ToScreen(curve->points.front(), zoom, origin), 4.f * zoom, IM_COL32(255, 255, 255, 255));
+        drawList->AddCircleFilled(NodeManager::ToScreen(curve->points.back(), zoom, origin), 4.f * zoom, IM_COL32(255, 255, 255, 255));
         
-        drawList->AddBezierCubic(inputPosition, controlPoint1, controlPoint2, outputPosition, IM_COL32(255, 255, 255, 255), 2 * zoom, m_bezierSegmentCount);
+        DrawLinkCurve(drawList, *curve, zoom, origin, IM_COL32(255, 255, 255, 255), 2 * zoom);
+    }
+}
+
+void LinkManager::DrawLinkCurve(ImDrawList* drawList, const LinkCurve& curve, float zoom, const Vec2f& origin, uint32_t color, float thickness)
+{
+    m_screenPoints.resize(curve.points.size());
+    for (size_t i = 0; i < curve.points.size(); i++)
+    {
+        m_screenPoints[i] = NodeManager::ToScreen(curve.points[i], zoom, origin);
     }
+    drawList->AddPolyline(m_screenPoints.data(), static_cast<int>(m_screenPoints.size()), color, ImDrawFlags_None, thickness);
 }
 
 void LinkManager::CreateLink(const NodeRef& fromNode, const uint32_t fromOutput, const NodeRef& toNode, const uint32_t toOutput)
@@ -186,38 +142,45 @@ void LinkManager::CreateLink(const NodeRef& fromNode, const uint32_t fromOutput,
 
 void LinkManager::CreateLink(UUID fromNodeIndex, const uint32_t fromOutputIndex, UUID toNodeIndex, const uint32_t toOutputIndex)
 {
-    AddLink(std::make_shared<Link>(std::move(fromNodeIndex), fromOutputIndex, std::move(toNodeIndex), toOutputIndex));
+    AddLink(Link(std::move(fromNodeIndex), fromOutputIndex, std::move(toNodeIndex), toOutputIndex));
 }
 
-LinkWeakRef LinkManager::AddLink(Link link)
+LinkHandle LinkManager::AddLink(const Link& link)
 {
-    auto sharedPtr = std::make_shared<Link>(std::move(link));
-    AddLink(sharedPtr);
-    return sharedPtr;
-}
+    const LinkHandle handle = InsertLink(link);
+    if (!handle.IsValid())
+        return handle;
 
-void LinkManager::AddLink(const LinkRef& link)
-{
-    auto input = m_nodeManager->GetInput(link->toNodeIndex, link->toInputIndex);
-    auto output = m_nodeManager->GetOutput(link->fromNodeIndex, link->fromOutputIndex);
+    auto input = m_nodeManager->GetInput(link.toNodeIndex, link.toInputIndex);
+    auto output = m_nodeManager->GetOutput(link.fromNodeIndex, link.fromOutputIndex);
 
     input.lock()->SetLinked(true);
     output.lock()->SetLinked(true);
-    
-    m_links.push_back(link);
+
+    return handle;
 }
 
-void LinkManager::RemoveLink(uint32_t index, bool removeOnLink /*= true*/)
+void LinkManager::RemoveLink(const LinkHandle& link, bool removeOnLink /*= true*/)
 {
+    const Link* linkPtr = m_links.Get(link);
+    if (!linkPtr)
+        return;
     if (removeOnLink)
     {
-        auto input = m_nodeManager->GetInput(m_links[index]->toNodeIndex, m_links[index]->toInputIndex);
-        auto output = m_nodeManager->GetOutput(m_links[index]->fromNodeIndex, m_links[index]->fromOutputIndex);
+        auto input = m_nodeManager->GetInput(linkPtr->toNodeIndex, linkPtr->toInputIndex);
+        auto output = m_nodeManager->GetOutput(linkPtr->fromNodeIndex, linkPtr->fromOutputIndex);
 
         input.lock()->SetLinked(false);
         output.lock()->SetLinked(false);
     }
-    m_links.erase(m_links.begin() + index);
+    UnindexLink(link);
+
+    // Same swap removal as the link storage so the curves stay in step
+    const uint32_t denseIndex = m_links.GetDenseIndex(link);
+    if (denseIndex != m_linkCurves.size() - 1)
+        m_linkCurves[denseIndex] = std::move(m_linkCurves.back());
+    m_linkCurves.pop_back();
+    m_links.Erase(link);
 }
 
 void LinkManager::RemoveLink(const NodeRef& fromNode, const uint32_t fromOutput, const NodeRef& toNode, const uint32_t toOutput)
@@ -227,59 +190,50 @@ void LinkManager::RemoveLink(const NodeRef& fromNode, const uint32_t fromOutput,
 
 void LinkManager::RemoveLink(const UUID& fromNodeIndex, const uint32_t fromOutputIndex, const UUID& toNodeIndex, const uint32_t toOutputIndex)
 {
-    for (uint32_t i = 0; i < m_links.size(); i++)
+    const NodeLinks* nodeLinks = GetNodeLinks(toNodeIndex);
+    if (!nodeLinks || toOutputIndex >= nodeLinks->inputs.size())
+        return;
+    // Iterates the index itself, removing changes it so the loop stops at the first match
+    for (const LinkHandle link : nodeLinks->inputs[toOutputIndex])
     {
-        if (m_links[i]->fromNodeIndex == fromNodeIndex &&
-            m_links[i]->fromOutputIndex == fromOutputIndex &&
-            m_links[i]->toNodeIndex == toNodeIndex &&
-            m_links[i]->toInputIndex == toOutputIndex)
+        const Link* linkPtr = m_links.Get(link);
+        if (linkPtr->fromNodeIndex == fromNodeIndex && linkPtr->fromOutputIndex == fromOutputIndex)
         {
-            RemoveLink(i);
+            RemoveLink(link);
             break;
         }
     }
 }
 
-void LinkManager::RemoveLink(const LinkWeakRef& link)
+void LinkManager::RemoveLink(const Link& link)
 {
-    LinkRef sharedPtr = link.lock();
-    RemoveLink(sharedPtr->fromNodeIndex, sharedPtr->fromOutputIndex, sharedPtr->toNodeIndex, sharedPtr->toInputIndex);
+    RemoveLink(link.fromNodeIndex, link.fromOutputIndex, link.toNodeIndex, link.toInputIndex);
 }
 
 void LinkManager::RemoveLink(const InputRef& input)
 {
-    for (uint32_t i = 0; i < m_links.size(); i++)
-    {
-        if (m_links[i]->toNodeIndex == input->parentUUID && m_links[i]->toInputIndex == input->index)
-        {
-            RemoveLink(i);
-            break;
-        }
-    }
+    RemoveLink(GetLinkLinkedToInput(input->parentUUID, input->index));
 }
 
 void LinkManager::RemoveLinks(const OutputRef& output)
 {
-    for (uint32_t i = 0; i < m_links.size(); i++)
+    // GetLinksWithOutput returns a copy, the index is modified while removing
+    for (const LinkHandle& link : GetLinksWithOutput(output))
     {
-        if (m_links[i]->fromNodeIndex == output->parentUUID && m_links[i]->fromOutputIndex == output->index)
-        {
-            RemoveLink(i);
-            i--;
-        }
+        RemoveLink(link);
     }
 }
 
 void LinkManager::RemoveLinks(const NodeRef& node)
 {
-    for (uint32_t i = 0; i < m_links.size(); i++)
+    // GetLinksWithNode returns a copy, the index is modified while removing
+    for (const LinkHandle& link : GetLinksWithNode(node->GetUUID()))
     {
-        if (m_links[i]->fromNodeIndex == node->GetUUID() || m_links[i]->toNodeIndex == node->GetUUID())
-        {
-            RemoveLink(i);
-            i--;
-        }
+        RemoveLink(link);
     }
+    m_nodeLinks.erase(node->GetUUID());
+    m_order.RemoveNode(node->GetUUID());
+    m_graphVersion++;
 }
 
 bool LinkManager::CanCreateLink(const Link& link) const
@@ -301,10 +255,14 @@ bool LinkManager::CanCreateLink(const Link& link) const
     if (!fromOutput || !toInput || fromNode == toNode || fromOutput->type != toInput->type)
         return false;
 
+    // The shader is generated by walking the graph, it has to stay acyclic
+    if (m_order.WouldCreateCycle(link.fromNodeIndex, link.toNodeIndex))
+        return false;
+
     /*
-    for (const LinkRef& inLink : m_links)
+    for (const Link& inLink : GetLinks())
     {
-        if (inLink->toNodeIndex == link.toNodeIndex && inLink->toInputIndex == link.toInputIndex)
+        if (inLink.toNodeIndex == link.toNodeIndex && inLink.toInputIndex == link.toInputIndex)
             return false;
     }
     */
@@ -312,155 +270,81 @@ bool LinkManager::CanCreateLink(const Link& link) const
     return true;
 }
 
-bool LinkManager::IsPointHoverLineSegment(Vec2f pointPosition, Vec2f fromPosition, Vec2f toPosition, float threshold)
-{
-    Vec2f lineVec = toPosition - fromPosition;
-    Vec2f pointVec = pointPosition - fromPosition;
-
-    float lineLengthSq = lineVec.Dot(lineVec);
-    float projection = pointVec.Dot(lineVec) / lineLengthSq;
-
-    if (projection < 0.0f || projection > 1.0f) {
-        return false;
-    }
-
-    Vec2f closestPoint = fromPosition + lineVec * projection;
-    Vec2f hoverVec = pointPosition - closestPoint;
-
-    return hoverVec.Length() <= threshold;
-}
-
-bool LinkManager::IsPointHoverBezier(Vec2f pointPosition, Vec2f inputPosition, Vec2f controlPoint1, Vec2f controlPoint2,
-                                     Vec2f outputPosition, float threshold, int numSamples)
+std::vector<LinkHandle> LinkManager::GetLinksWithOutput(const OutputRef& output) const
 {
-    for (int i = 0; i <= numSamples; ++i)
-    {
-        float t = i / static_cast<float>(numSamples);
-        
-        // Calculate the point on the cubic Bezier curve for this t
-        Vec2f bezierPoint = 
-            inputPosition * (1 - t) * (1 - t) * (1 - t) +
-            controlPoint1 * 3 * (1 - t) * (1 - t) * t +
-            controlPoint2 * 3 * (1 - t) * t * t +
-            outputPosition* t * t * t;
-        
-        // Calculate distance from the point to the Bezier point
-        const float distance = (pointPosition - bezierPoint).Length();
-        
-        // Check if this distance is within the threshold
-        if (distance < threshold)
-        {
-            return true;
-        }
-    }
-    return false;
+    const NodeLinks* nodeLinks = GetNodeLinks(output->parentUUID);
+    if (!nodeLinks || output->index >= nodeLinks->outputs.size())
+        return {};
+    return nodeLinks->outputs[output->index];
 }
 
-bool LinkManager::BezierIntersectSquare(Vec2f inputPosition, Vec2f controlPoint1, Vec2f controlPoint2,
-    Vec2f outputPosition, Vec2f rectMin, Vec2f rectMax)
+LinkHandle LinkManager::GetLinkLinkedToInput(const UUID& uuid, uint32_t index) const
 {
-    const int segments = 10; // Increase for higher accuracy
-    std::vector<Vec2f> bezierPoints;
-
-    // Generate points along the Bezier curve
-    for (int i = 0; i <= segments; ++i)
-    {
-        float t = static_cast<float>(i) / segments;
-        bezierPoints.push_back(Utils::CubicBezierPoint(inputPosition, controlPoint1, controlPoint2, outputPosition, t));
-    }
-
-    // Check each segment of the Bezier curve against the rectangle
-    for (int i = 0; i < segments; ++i)
-    {
-        if (Utils::LineIntersectsRect(bezierPoints[i], bezierPoints[i + 1], rectMin, rectMax))
-        {
-            return true;
-        }
-    }
-
-    return false;
+    const NodeLinks* nodeLinks = GetNodeLinks(uuid);
+    if (!nodeLinks || index >= nodeLinks->inputs.size() || nodeLinks->inputs[index].empty())
+        return {};
+    return nodeLinks->inputs[index].front();
 }
 
-std::vector<LinkWeakRef> LinkManager::GetLinksWithOutput(const OutputRef& output) const
+std::vector<LinkHandle> LinkManager::GetLinksWithInput(const UUID& uuid, uint32_t index) const
 {
-    std::vector<LinkWeakRef> links;
-    for (uint32_t i = 0; i < m_links.size(); i++)
-    {
-        if (m_links[i]->fromNodeIndex == output->parentUUID && m_links[i]->fromOutputIndex == output->index)
-        {
-            links.push_back(m_links[i]);
-        }
-    }
-    return links;
+    const NodeLinks* nodeLinks = GetNodeLinks(uuid);
+    if (!nodeLinks || index >= nodeLinks->inputs.size())
+        return {};
+    return nodeLinks->inputs[index];
 }
 
-LinkWeakRef LinkManager::GetLinkLinkedToInput(const UUID& uuid, uint32_t index) const
+std::vector<LinkHandle> LinkManager::GetLinksWithNode(const UUID& uuid) const
 {
-    for (const LinkRef& link : m_links)
+    const NodeLinks* nodeLinks = GetNodeLinks(uuid);
+    if (!nodeLinks)
+        return {};
+    std::vector<LinkHandle> links;
+    for (const std::vector<LinkHandle>& slot : nodeLinks->inputs)
     {
-        if (link->toNodeIndex == uuid && link->toInputIndex == index)
-        {
-            return link;
-        }
+        links.insert(links.end(), slot.begin(), slot.end());
     }
-    return {};
-}
-
-std::vector<LinkWeakRef> LinkManager::GetLinksWithInput(const UUID& uuid, uint32_t index) const
-{
-    std::vector<LinkWeakRef> links;
-    for (const LinkRef& link : m_links)
+    for (const std::vector<LinkHandle>& slot : nodeLinks->outputs)
     {
-        if (link->toNodeIndex == uuid && link->toInputIndex == index)
-        {
-            links.push_back(link);
-        }
+        links.insert(links.end(), slot.begin(), slot.end());
     }
     return links;
 }
 
 bool LinkManager::HasLink(const OutputRef& output) const
 {
-    for (const LinkRef& link : m_links)
-    {
-        if (link->fromNodeIndex == output->parentUUID && link->fromOutputIndex == output->index)
-        {
-            return true;
-        }
-    }
-    return false;
+    const NodeLinks* nodeLinks = GetNodeLinks(output->parentUUID);
+    return nodeLinks && output->index < nodeLinks->outputs.size() && !nodeLinks->outputs[output->index].empty();
 }
 
 bool LinkManager::HasLink(const InputRef& input) const
 {
-    return std::any_of(m_links.begin(), m_links.end(), [&](const LinkRef& link) {
-        return link->toNodeIndex == input->parentUUID && link->toInputIndex == input->index;
-    });
+    const NodeLinks* nodeLinks = GetNodeLinks(input->parentUUID);
+    return nodeLinks && input->index < nodeLinks->inputs.size() && !nodeLinks->inputs[input->index].empty();
 }
 
-LinkWeakRef LinkManager::GetLinkClicked(float zoom, const Vec2f& origin, const Vec2f& mousePos) const
+LinkHandle LinkManager::GetLinkClicked(float zoom, const Vec2f& origin, const Vec2f& mousePos) const
 {
-    for (const LinkRef& link : m_links)
+    const Vec2f gridMousePos = NodeManager::ToGrid(mousePos, zoom, origin);
+
+    // The bounds in the grid are already padded by the threshold
+    std::vector<LinkHandle> candidates;
+    m_linkGrid.Query(gridMousePos, gridMousePos, candidates);
+
+    BezierBatch batch;
+    for (const LinkHandle& link : candidates)
     {
-        NodeRef fromNode = m_nodeManager->GetNode(link->fromNodeIndex).lock();
-        NodeRef toNode = m_nodeManager->GetNode(link->toNodeIndex).lock();
-        
-        Vec2f inputPosition = fromNode->GetOutputPosition(link->fromOutputIndex, origin, zoom);
-        Vec2f outputPosition = toNode->GetInputPosition(link->toInputIndex, origin, zoom);
-        
-        if (IsPointHoverBezier(mousePos, inputPosition, inputPosition + Vec2f(m_controlDistanceX, 0.0f) * zoom,
-                               outputPosition - Vec2f(m_controlDistanceX, 0.0f) * zoom, outputPosition, 3.f * zoom,
-                               m_bezierSegmentCount))
-        {
-            return link;
-        }
+        batch.Add(GetLinkCurve(link)->controlPoints);
     }
-    return {};
+    const int32_t hitIndex = BezierKernel::FindHit(batch, gridMousePos, c_linkPickThreshold);
+    if (hitIndex < 0)
+        return {};
+    return candidates[hitIndex];
 }
 
-void LinkManager::AddSelectedLink(const LinkRef& link)
+void LinkManager::AddSelectedLink(const LinkHandle& link)
 {
-    if (std::ranges::find_if(m_selectedLinks, [link](const LinkWeakRef& l) { return l.lock() == link; }) == m_selectedLinks.end())
+    if (std::ranges::find(m_selectedLinks, link) == m_selectedLinks.end())
         m_selectedLinks.push_back(link);
 }
 
@@ -480,21 +364,21 @@ void LinkManager::ClearSelectedLinks()
 
 void LinkManager::Serialize(CppSer::Serializer& serializer) const
 {
-    Serialize(serializer, m_links);
+    Serialize(serializer, m_links.GetValues());
 }
 
-void LinkManager::Serialize(CppSer::Serializer& serializer, const std::vector<LinkRef>& links)
+void LinkManager::Serialize(CppSer::Serializer& serializer, const std::vector<Link>& links)
 {
     serializer << CppSer::Pair::BeginMap << "Links";
     serializer << CppSer::Pair::Key << "Link Count" << CppSer::Pair::Value << links.size();
     serializer << CppSer::Pair::BeginTab;
-    for (const LinkRef& link : links)
+    for (const Link& link : links)
     {
         serializer << CppSer::Pair::BeginMap << "Link";
-        serializer << CppSer::Pair::Key << "From Node Index" << CppSer::Pair::Value << link->fromNodeIndex;
-        serializer << CppSer::Pair::Key << "From Output Index" << CppSer::Pair::Value << link->fromOutputIndex;
-        serializer << CppSer::Pair::Key << "To Node Index" << CppSer::Pair::Value << link->toNodeIndex;
-        serializer << CppSer::Pair::Key << "To Input Index" << CppSer::Pair::Value << link->toInputIndex;
+        serializer << CppSer::Pair::Key << "From Node Index" << CppSer::Pair::Value << link.fromNodeIndex;
+        serializer << CppSer::Pair::Key << "From Output Index" << CppSer::Pair::Value << link.fromOutputIndex;
+        serializer << CppSer::Pair::Key << "To Node Index" << CppSer::Pair::Value << link.toNodeIndex;
+        serializer << CppSer::Pair::Key << "To Input Index" << CppSer::Pair::Value << link.toInputIndex;
         serializer << CppSer::Pair::EndMap << "Link";
     }
     serializer << CppSer::Pair::EndTab;
@@ -503,11 +387,16 @@ void LinkManager::Serialize(CppSer::Serializer& serializer, const std::vector<Li
 
 void LinkManager::Deserialize(CppSer::Parser& parser)
 {
-    Deserialize(parser, m_links);
+    std::vector<Link> links;
+    Deserialize(parser, links);
+    for (const Link& link : links)
+    {
+        InsertLink(link);
+    }
     UpdateInputOutputLinks();
 }
 
-void LinkManager::Deserialize(CppSer::Parser& parser, std::vector<LinkRef>& links)
+void LinkManager::Deserialize(CppSer::Parser& parser, std::vector<Link>& links)
 {
     parser.PushDepth();
     uint32_t linkCount = parser["Link Count"].As<uint32_t>();
@@ -515,27 +404,174 @@ void LinkManager::Deserialize(CppSer::Parser& parser, std::vector<LinkRef>& link
     for (uint32_t i = 0; i < linkCount; i++)
     {
         parser.PushDepth();
-        LinkRef link = std::make_shared<Link>();
-        link->fromNodeIndex = parser["From Node Index"].As<uint64_t>();
-        link->fromOutputIndex = parser["From Output Index"].As<uint32_t>();
-        link->toNodeIndex = parser["To Node Index"].As<uint64_t>();
-        link->toInputIndex = parser["To Input Index"].As<uint32_t>();
-
-        links[i] = link;
+        Link& link = links[i];
+        link.fromNodeIndex = parser["From Node Index"].As<uint64_t>();
+        link.fromOutputIndex = parser["From Output Index"].As<uint32_t>();
+        link.toNodeIndex = parser["To Node Index"].As<uint64_t>();
+        link.toInputIndex = parser["To Input Index"].As<uint32_t>();
     }
 }
 
 void LinkManager::Clean()
 {
-    for (int i = 0; i < m_links.size(); i++)
+    for (const Link& link : m_links.GetValues())
     {
-        RemoveLink(i--);
+        auto input = m_nodeManager->GetInput(link.toNodeIndex, link.toInputIndex);
+        auto output = m_nodeManager->GetOutput(link.fromNodeIndex, link.fromOutputIndex);
+
+        input.lock()->SetLinked(false);
+        output.lock()->SetLinked(false);
     }
-    
+
+    m_links.Clear();
+    m_nodeLinks.clear();
+    m_order.Clear();
+    m_graphVersion++;
     m_selectedLinks.clear();
+    m_linkCurves.clear();
+    m_linkGrid.Clear();
 }
 
 NodeWindow* LinkManager::GetMainWindow() const
 {
     return m_nodeManager->GetMainWindow();
 }
+
+LinkHandle LinkManager::InsertLink(const Link& link)
+{
+    if (!m_order.AddEdge(link.fromNodeIndex, link.toNodeIndex))
+    {
+        std::cout << "Link ignored, it would create a cycle: " << link.fromNodeIndex << " -> " << link.toNodeIndex << std::endl;
+        return {};
+    }
+
+    const LinkHandle handle = m_links.Insert(link);
+    m_linkCurves.emplace_back();
+    IndexLink(handle);
+    m_graphVersion++;
+    return handle;
+}
+
+void LinkManager::IndexLink(const LinkHandle& handle)
+{
+    const Link& link = *m_links.Get(handle);
+    NodeLinks& toLinks = m_nodeLinks[link.toNodeIndex];
+    if (toLinks.inputs.size() <= link.toInputIndex)
+        toLinks.inputs.resize(link.toInputIndex + 1);
+    toLinks.inputs[link.toInputIndex].push_back(handle);
+
+    NodeLinks& fromLinks = m_nodeLinks[link.fromNodeIndex];
+    if (fromLinks.outputs.size() <= link.fromOutputIndex)
+        fromLinks.outputs.resize(link.fromOutputIndex + 1);
+    fromLinks.outputs[link.fromOutputIndex].push_back(handle);
+
+    UpdateLinkCurve(handle);
+}
+
+void LinkManager::UnindexLink(const LinkHandle& handle)
+{
+    const Link& link = *m_links.Get(handle);
+    auto removeFromSlot = [&handle](std::vector<std::vector<LinkHandle>>& slots, uint32_t index)
+    {
+        if (index >= slots.size())
+            return;
+        std::erase(slots[index], handle);
+    };
+
+    if (auto it = m_nodeLinks.find(link.toNodeIndex); it != m_nodeLinks.end())
+    {
+        removeFromSlot(it->second.inputs, link.toInputIndex);
+    }
+    if (auto it = m_nodeLinks.find(link.fromNodeIndex); it != m_nodeLinks.end())
+    {
+        removeFromSlot(it->second.outputs, link.fromOutputIndex);
+    }
+    m_order.RemoveEdge(link.fromNodeIndex, link.toNodeIndex);
+    m_graphVersion++;
+
+    m_linkGrid.Remove(handle);
+}
+
+const NodeLinks* LinkManager::GetNodeLinks(const UUID& uuid) const
+{
+    auto it = m_nodeLinks.find(uuid);
+    if (it == m_nodeLinks.end())
+        return nullptr;
+    return &it->second;
+}
+
+bool LinkManager::GetLinkControlPoints(const Link& link, Vec2f controlPoints[4]) const
+{
+    Node* fromNode = m_nodeManager->FindNode(link.fromNodeIndex);
+    Node* toNode = m_nodeManager->FindNode(link.toNodeIndex);
+    if (!fromNode || !toNode)
+        return false;
+
+    controlPoints[0] = fromNode->GetOutputPosition(link.fromOutputIndex);
+    controlPoints[3] = toNode->GetInputPosition(link.toInputIndex);
+    controlPoints[1] = controlPoints[0] + Vec2f(m_controlDistanceX, 0.0f);
+    controlPoints[2] = controlPoints[3] - Vec2f(m_controlDistanceX, 0.0f);
+    return true;
+}
+
+void LinkManager::UpdateLinkCurve(const LinkHandle& link)
+{
+    LinkCurve& curve = m_linkCurves[m_links.GetDenseIndex(link)];
+    if (!GetLinkControlPoints(*m_links.Get(link), curve.controlPoints))
+    {
+        curve.points.clear();
+        m_linkGrid.Remove(link);
+        return;
+    }
+
+    const Vec2f* controlPoints = curve.controlPoints;
+    curve.points.resize(m_bezierSegmentCount + 1);
+    for (int i = 0; i <= m_bezierSegmentCount; i++)
+    {
+        float t = static_cast<float>(i) / m_bezierSegmentCount;
+        curve.points[i] = Utils::CubicBezierPoint(controlPoints[0], controlPoints[1], controlPoints[2], controlPoints[3], t);
+    }
+
+    // The exact curve can bulge past the flattened points but never past its control points,
+    // padded so a pick near the curve still finds it
+    curve.min = controlPoints[0];
+    curve.max = controlPoints[0];
+    for (int i = 1; i < 4; i++)
+    {
+        curve.min = Vec2f(std::min(curve.min.x, controlPoints[i].x), std::min(curve.min.y, controlPoints[i].y));
+        curve.max = Vec2f(std::max(curve.max.x, controlPoints[i].x), std::max(curve.max.y, controlPoints[i].y));
+    }
+    curve.min = curve.min - Vec2f(c_linkPickThreshold);
+    curve.max = curve.max + Vec2f(c_linkPickThreshold);
+
+    m_linkGrid.Set(link, curve.min, curve.max);
+}
+
+const LinkCurve* LinkManager::GetLinkCurve(const LinkHandle& link) const
+{
+    const uint32_t denseIndex = m_links.GetDenseIndex(link);
+    if (denseIndex == UINT32_MAX || m_linkCurves[denseIndex].points.empty())
+        return nullptr;
+    return &m_linkCurves[denseIndex];
+}
+
+void LinkManager::UpdateLinkCurves(const UUID& nodeUUID)
+{
+    const NodeLinks* nodeLinks = GetNodeLinks(nodeUUID);
+    if (!nodeLinks)
+        return;
+    for (const std::vector<LinkHandle>& slot : nodeLinks->inputs)
+    {
+        for (const LinkHandle& link : slot)
+        {
+            UpdateLinkCurve(link);
+        }
+    }
+    for (const std::vector<LinkHandle>& slot : nodeLinks->outputs)
+    {
+        for (const LinkHandle& link : slot)
+        {
+            UpdateLinkCurve(link);
+        }
+    }
+}
@@ -312,6 +312,20 @@ void Node::DrawPreview(Vec2f pMin, float zoom) const
     }
 
     drawList->AddImage(reinterpret_cast<ImTextureID>(m_framebuffer->GetRenderTexture()), imageMin, imageMax, ImVec2(0, 1), ImVec2(1, 0));
+
+    // The image shows the previous program until the new one is linked
+    if (!m_shader)
+        return;
+    const ShaderStatus status = m_shader->GetStatus();
+    if (status == ShaderStatus::Failed)
+    {
+        drawList->AddRect(imageMin, imageMax, IM_COL32(220, 50, 50, 255), 0.f, 0, 2.f * zoom);
+        drawList->AddText(Font::GetFontScaled(), 12 * zoom, imageMin + Vec2f(4, 4) * zoom, IM_COL32(220, 50, 50, 255), "Error");
+    }
+    else if (status != ShaderStatus::Ready)
+    {
+        drawList->AddText(Font::GetFontScaled(), 12 * zoom, imageMin + Vec2f(4, 4) * zoom, IM_COL32(255, 255, 255, 255), "Compiling...");
+    }
 }
 
 void Node::Draw(float zoom, const Vec2f& origin) const
@@ -482,6 +496,7 @@ void Node::AddInput(const std::string& name, Type type)
     int size = CalculateSize(p_inputs.size());
 
     p_size.y = std::max(p_size.y, static_cast<float>(size));
+    SyncHotData();
 }
 
 auto Node::AddOutput(const std::string& name, Type type) -> void
@@ -490,26 +505,21 @@ auto Node::AddOutput(const std::string& name, Type type) -> void
     int size = CalculateSize(p_outputs.size());
 
     p_size.y = std::max(p_size.y, static_cast<float>(size));
+    SyncHotData();
 }
 
 void Node::RemoveInput(uint32_t index)
 {
+    auto linkManager = p_nodeManager->GetLinkManager();
+    linkManager->RemoveLink(p_inputs[index]);
+
     p_inputs.erase(p_inputs.begin() + index);
     int size = CalculateSize(p_inputs.size());
 
     int size2 = CalculateSize(p_outputs.size());
-
-    auto linkManager = p_nodeManager->GetLinkManager();
-    for (auto& link : linkManager->GetLinks())
-    {
-        if (link->toNodeIndex == p_uuid && link->toInputIndex == index)
-        {
-            linkManager->RemoveLink(link->toInputIndex, false);
-            break;
-        }
-    }
     
     p_size.y = static_cast<float>(std::max(size, size2));
+    SyncHotData();
 }
 
 void Node::RemoveOutput(uint32_t index)
@@ -525,6 +535,7 @@ void Node::RemoveOutput(uint32_t index)
 
     p_size.y = static_cast<float>(std::max(size, size2));
     p_outputs.erase(p_outputs.begin() + index);
+    SyncHotData();
 }
 
 Vec2f Node::GetInputPosition(const uint32_t index, const Vec2f& origin, float zoom) const
@@ -547,21 +558,15 @@ Vec2f Node::GetOutputPosition(uint32_t index) const
     return p_position + Vec2f(p_size.x - 10, c_topSize + 15 + c_pointSize * index);
 }
 
-std::vector<LinkWeakRef> Node::GetLinks() const
+std::vector<LinkHandle> Node::GetLinks() const
 {
-    for (auto& link : p_nodeManager->GetLinkManager()->GetLinks())
-    {
-        if (link->toNodeIndex == p_uuid || link->fromNodeIndex == p_uuid)
-        {
-            return { link };
-        }
-    }
-    return {};
+    return p_nodeManager->GetLinkManager()->GetLinksWithNode(p_uuid);
 }
 
 void Node::SetPosition(const Vec2f& position)
 {
     p_position = position;
+    SyncHotData();
 }
 
 void Node::ResetUUID()
@@ -573,6 +578,7 @@ void Node::ComputeNodeSize()
 {
     float textSizeX = ImGui::CalcTextSize(p_name.c_str()).x + 20.f;
     p_size.x = std::max(textSizeX, p_size.x);
+    SyncHotData();
 }
 
 void Node::GetPreviewTriangle(Vec2f& trianglePos, Vec2f& triangleSize, const Vec2f& nodeMin, const Vec2f& nodeMax, float zoom)
@@ -742,54 +748,6 @@ void Node::InternalDeserialize(CppSer::Parser& parser)
 }
 
 
-std::string Node::ToShader(ShaderMaker* shaderMaker, const FuncStruct& funcStruct) const
-{
-    std::string content;
-    auto& variableNames = shaderMaker->m_variablesNames;
-    auto& allVariableNames = shaderMaker->m_allVariableNames;
-    auto toFormatList = GetFormatStrings();
-    for (int k = 0; k < p_outputs.size(); k++)
-    {
-        if (funcStruct.outputs.size() <= k)
-            break;
-        std::string variableName = funcStruct.outputs[k];
-        std::string glslType = ShaderMaker::TypeToGLSLType(p_outputs[k]->type);
-            
-        std::string thisContent = glslType + " " + variableName + " = ";
-        if (allVariableNames.contains(variableName))
-            continue;
-        allVariableNames.insert(variableName);
-            
-        std::string toFormat = toFormatList[k];
-        std::string secondHalf = toFormat;
-        toFormat.clear();
-        for (int j = 0; j < p_inputs.size(); j++)
-        {
-            InputRef input = p_inputs[j];
-            size_t index = secondHalf.find_first_of("%") + 2;
-            if (index == std::string::npos)
-                break;
-            std::string firstHalf = secondHalf.substr(0, index);
-            if (index != std::string::npos)
-                secondHalf = secondHalf.substr(index);
-            if (!input->isLinked)
-            {
-                variableNames.push_back(ShaderMaker::GetValueAsString(input));
-            }
-            auto parentVariableName = funcStruct.inputs[j];
-            if (parentVariableName.empty())
-                parentVariableName = variableNames.back();
-            toFormat += FormatString(firstHalf, parentVariableName.c_str());
-        }
-        thisContent += toFormat + secondHalf + ";\n";
-
-        content += thisContent;
-
-        // std::cout << thisContent << '\n';
-    }
-    return content;
-}
-
 Node* Node::Clone() const
 {
     auto node = new Node(p_name);
@@ -824,6 +782,13 @@ void Node::OpenPreview(bool open)
     {
         p_nodeManager->GetMainWindow()->RemovePreviewNode(p_uuid);
     }
+    SyncHotData();
+}
+
+void Node::SyncHotData() const
+{
+    if (p_nodeManager)
+        p_nodeManager->SyncHotData(*this);
 }
 
 void Node::SetUUID(const UUID& uuid)
@@ -50,18 +50,40 @@ NodeManager::~NodeManager()
 
 void NodeManager::AddNode(const NodeRef& node)
 {
-    if (m_nodes.contains(node->p_uuid))
+    if (m_uuidToHandle.contains(node->p_uuid))
     {
         std::cout << "Node with UUID " << node->p_uuid << " already exists\n";
         return;
     }
-    m_nodes[node->p_uuid] = node;
+    node->p_handle = m_nodes.Insert(node);
     node->p_nodeManager = this;
+    // The cached orders may refer to this node before it existed
+    m_evaluationOrders.clear();
+    m_uuidToHandle[node->p_uuid] = node->p_handle;
+    m_hotData.PushBack();
+    SyncHotData(*node);
+    m_nodeGrid.Set(node->p_handle, m_hotData.GetMin(m_hotData.Size() - 1), m_hotData.GetMax(m_hotData.Size() - 1));
+    if (!node->p_computed)
+        m_uncomputedNodes.push_back(node->p_handle);
 }
 
 void NodeManager::RemoveNode(const UUID& uuid)
 {
-    m_nodes.erase(uuid);
+    auto it = m_uuidToHandle.find(uuid);
+    if (it == m_uuidToHandle.end())
+        return;
+    const NodeHandle handle = it->second;
+    m_evaluationOrders.clear();
+    if (NodeRef* node = m_nodes.Get(handle))
+    {
+        (*node)->p_selected = false;
+        (*node)->p_handle = {};
+    }
+    std::erase(m_selectedNodes, handle);
+    m_hotData.SwapRemove(m_nodes.GetDenseIndex(handle));
+    m_nodeGrid.Remove(handle);
+    m_nodes.Erase(handle);
+    m_uuidToHandle.erase(it);
 }
 
 void NodeManager::RemoveNode(const NodeWeak& weak)
@@ -76,15 +98,16 @@ void NodeManager::UpdateDelete()
     const bool deleteClicked = ImGui::IsKeyPressed(ImGuiKey_Delete);
     if (!deleteClicked)
         return;
-    auto action = std::make_shared<ActionDeleteNodesAndLinks>(this, m_selectedNodes, m_linkManager->GetSelectedLinks());
+    std::vector<NodeWeak> selectedNodes = GetSelectedNodes();
+    auto action = std::make_shared<ActionDeleteNodesAndLinks>(this, selectedNodes, m_linkManager->GetSelectedLinks());
     m_linkManager->DeleteSelectedLinks();
     
-    for (int i = 0; i < m_selectedNodes.size(); i++)
+    // RemoveNode also removes the node from the selection
+    for (const NodeWeak& node : selectedNodes)
     {
-        if (!m_selectedNodes[i].lock()->p_allowInteraction)
+        if (!node.lock()->p_allowInteraction)
             continue;
-        RemoveNode(m_selectedNodes[i]);
-        m_selectedNodes.erase(m_selectedNodes.begin() + i--);
+        RemoveNode(node);
     }
     ActionManager::AddAction(action);
 }
@@ -93,7 +116,7 @@ void NodeManager::OnInputClicked(const NodeRef& node, bool altClicked, const uin
 {
     if (altClicked)
     {
-        std::vector<LinkWeakRef> linkWithInput = m_linkManager->GetLinksWithInput(node->GetUUID(), i);
+        std::vector<LinkHandle> linkWithInput = m_linkManager->GetLinksWithInput(node->GetUUID(), i);
 
         SetUserInputState(UserInputState::Busy);
 
@@ -120,7 +143,7 @@ void NodeManager::OnOutputClicked(const NodeRef& node, bool altClicked, uint32_t
 {
     if (altClicked)
     {
-        std::vector<LinkWeakRef> links = m_linkManager->GetLinksWithOutput(node->GetOutput(i));
+        std::vector<LinkHandle> links = m_linkManager->GetLinksWithOutput(node->GetOutput(i));
         std::vector<NodeWeak> nodes = {};
         
         auto action = std::make_shared<ActionDeleteNodesAndLinks>(this, nodes, links);
@@ -185,27 +208,22 @@ void NodeManager::UpdateCurrentLink()
 {
     if (m_currentLink.fromNodeIndex != UUID_NULL && m_currentLink.toNodeIndex != UUID_NULL) // Is Linked
     {
-        auto link = m_linkManager->AddLink(m_currentLink);
-        auto action =std::make_shared<ActionCreateLink>(this, link.lock());
-        ActionManager::AddAction(action);
+        if (m_linkManager->AddLink(m_currentLink).IsValid())
+        {
+            auto action =std::make_shared<ActionCreateLink>(this, m_currentLink);
+            ActionManager::AddAction(action);
+        }
         ClearCurrentLink();
     }
 }
 
-void NodeManager::UpdateNodeSelection(NodeRef node, float zoom, const Vec2f& origin, const Vec2f& mousePos,
+void NodeManager::UpdateNodeSelection(const NodeRef& node, float zoom, const Vec2f& origin, const Vec2f& mousePos,
                                       bool mouseClicked, bool ctrlDown, bool& wasNodeClicked)
 {
+    // Square selection is done by SelectNodesInSquare
     if (m_selectionSquare.shouldDraw)
-    {
-        if (node->IsSelected(m_selectionSquare.min, m_selectionSquare.max, origin, zoom))
-        {
-            if (!node->p_selected)
-            {
-                AddSelectedNode(node);
-            }
-        }
-    }
-    else if (mouseClicked && !wasNodeClicked && node->IsSelected(mousePos, origin, zoom)
+        return;
+    if (mouseClicked && !wasNodeClicked && node->IsSelected(mousePos, origin, zoom)
         && (m_userInputState == UserInputState::None || m_userInputState == UserInputState::ClickNode))
     {
         SetUserInputState(UserInputState::ClickNode);
@@ -226,11 +244,10 @@ void NodeManager::UpdateNodeSelection(NodeRef node, float zoom, const Vec2f& ori
         }
             
         m_onClickPos = mousePos;
-        for (auto& selectedNode : m_selectedNodes)
+        for (const NodeHandle& selectedHandle : m_selectedNodes)
         {
-            auto selectedNodeLock = selectedNode.lock();
-            Vec2f posOnScreen = ToScreen(selectedNode.lock()->p_position, zoom, origin);
-            selectedNodeLock->p_positionOnClick = posOnScreen ;
+            Node* selectedNode = GetNode(selectedHandle);
+            selectedNode->p_positionOnClick = ToScreen(selectedNode->p_position, zoom, origin);
         }
 
         wasNodeClicked = true;
@@ -251,15 +268,14 @@ void NodeManager::UpdateDragging(float zoom, const Vec2f& origin, const Vec2f& m
     }
         
     // Move nodes
-    for (const auto& selectedNode : m_selectedNodes)
+    for (const NodeHandle& selectedHandle : m_selectedNodes)
     {
+        Node* currentSelectedNode = GetNode(selectedHandle);
         if (changePosition)
         {
-            Vec2f posOnScreen = ToScreen(selectedNode.lock()->p_position, zoom, origin);
-            selectedNode.lock()->p_positionOnClick = posOnScreen ;
+            currentSelectedNode->p_positionOnClick = ToScreen(currentSelectedNode->p_position, zoom, origin);
             m_onClickPos = mousePos;
         }
-        Node* currentSelectedNode = selectedNode.lock().get();
         Vec2f offset = m_onClickPos - currentSelectedNode->p_positionOnClick;
         Vec2f newPosition = ToGrid(mousePos - offset, zoom, origin) ;
         
@@ -282,6 +298,29 @@ void NodeManager::UpdateSelectionSquare(float zoom, const Vec2f& origin, const V
     }
 }
 
+void NodeManager::SelectNodesInSquare(const Vec2f& min, const Vec2f& max)
+{
+    std::vector<NodeHandle> nodesInSquare;
+    QueryNodes(min, max, nodesInSquare);
+    for (const NodeHandle& handle : nodesInSquare)
+    {
+        const uint32_t index = m_nodes.GetDenseIndex(handle);
+        if (!m_hotData.HasFlag(index, NodeHotData::Selected))
+        {
+            AddSelectedNode(m_nodes.GetValues()[index]);
+        }
+    }
+}
+
+void NodeManager::QueryNodes(const Vec2f& min, const Vec2f& max, std::vector<NodeHandle>& result) const
+{
+    m_nodeGrid.Query(min, max, result);
+    std::ranges::sort(result, [&](const NodeHandle& a, const NodeHandle& b)
+    {
+        return m_nodes.GetDenseIndex(a) < m_nodes.GetDenseIndex(b);
+    });
+}
+
 void NodeManager::UpdateNodes(float zoom, const Vec2f& origin, const Vec2f& mousePos)
 {
     if (!m_isGridHovered && !m_firstFrame)
@@ -308,19 +347,44 @@ void NodeManager::UpdateNodes(float zoom, const Vec2f& origin, const Vec2f& mous
         ClearSelectedNodes();
     }
 
-    for (NodeRef& node : m_nodes | std::views::values)
+    if (m_selectionSquare.shouldDraw)
+    {
+        // The square can be drawn in any direction
+        Vec2f squareStart = ToGrid(m_selectionSquare.min, zoom, origin);
+        Vec2f squareEnd = ToGrid(m_selectionSquare.max, zoom, origin);
+        SelectNodesInSquare(Vec2f(std::min(squareStart.x, squareEnd.x), std::min(squareStart.y, squareEnd.y)),
+                            Vec2f(std::max(squareStart.x, squareEnd.x), std::max(squareStart.y, squareEnd.y)));
+    }
+
+    for (const NodeHandle& handle : m_uncomputedNodes)
     {
-        if (!node->p_computed)
+        if (Node* node = GetNode(handle))
         {
             node->p_computed = true;
             node->ComputeNodeSize();
         }
-        node->p_isVisible = node->IsNodeVisible(origin, zoom);
+    }
+    m_uncomputedNodes.clear();
 
-        if (!node->p_isVisible)
-            continue;
+    // Visible area in grid space
+    const Vec2f windowPos = ImGui::GetWindowPos();
+    m_visibleNodes.clear();
+    QueryNodes(ToGrid(windowPos, zoom, origin), ToGrid(windowPos + Vec2f(ImGui::GetWindowSize()), zoom, origin), m_visibleNodes);
 
+    // Only the nodes under the mouse can be clicked, the margin covers the stream circles
+    for (const NodeHandle& handle : m_hoveredNodes)
+    {
+        if (Node* node = GetNode(handle))
+            node->p_previewHovered = false;
+    }
+    m_hoveredNodes.clear();
+    const Vec2f mouseGridPos = ToGrid(mousePos, zoom, origin);
+    const Vec2f hoverMargin = Vec2f(c_streamCircleRadius * c_hoveredCircleRadiusFactor);
+    QueryNodes(mouseGridPos - hoverMargin, mouseGridPos + hoverMargin, m_hoveredNodes);
 
+    for (const NodeHandle& handle : m_hoveredNodes)
+    {
+        const NodeRef& node = *m_nodes.Get(handle);
         if (m_userInputState == UserInputState::None)
         {
             if (node->p_previewHovered = node->IsPreviewHovered(mousePos, origin, zoom))
@@ -336,8 +400,12 @@ void NodeManager::UpdateNodes(float zoom, const Vec2f& origin, const Vec2f& mous
         UpdateInputOutputClick(zoom, origin, mousePos, mouseClicked, node);
 
         UpdateNodeSelection(node, zoom, origin, mousePos, mouseClicked, ctrlClick, wasNodeClicked);
+    }
 
-        node->Update();
+    for (const NodeHandle& handle : m_visibleNodes)
+    {
+        if (Node* node = GetNode(handle))
+            node->Update();
     }
 
     m_linkManager->UpdateLinkSelection(origin, zoom);
@@ -410,7 +478,7 @@ void NodeManager::UpdateNodes(float zoom, const Vec2f& origin, const Vec2f& mous
         && ImGui::GetIO().MouseDelta != ImVec2(0.0f, 0.0f))
     {
         SetUserInputState(UserInputState::DragNode);
-        auto action = std::make_shared<ActionMoveNodes>(m_selectedNodes);
+        auto action = std::make_shared<ActionMoveNodes>(GetSelectedNodes());
         ActionManager::AddAction(action);
     }
     else if (m_userInputState == UserInputState::None
@@ -431,11 +499,12 @@ void NodeManager::UpdateNodes(float zoom, const Vec2f& origin, const Vec2f& mous
 void NodeManager::DrawNodes(float zoom, const Vec2f& origin, const Vec2f& mousePos) const
 {
     ImDrawList* drawList = ImGui::GetWindowDrawList();
-    for (const NodeRef& node : m_nodes | std::views::values)
+    const Vec2f windowPos = ImGui::GetWindowPos();
+    std::vector<NodeHandle> visibleNodes;
+    QueryNodes(ToGrid(windowPos, zoom, origin), ToGrid(windowPos + Vec2f(ImGui::GetWindowSize()), zoom, origin), visibleNodes);
+    for (const NodeHandle& handle : visibleNodes)
     {
-        if (!node->p_isVisible)
-            continue;
-        node->Draw(zoom, origin);
+        GetNode(handle)->Draw(zoom, origin);
     }
     
     if (m_userInputState == UserInputState::CreateLink)
@@ -451,11 +520,11 @@ void NodeManager::DrawNodes(float zoom, const Vec2f& origin, const Vec2f& mouseP
 
         if (m_currentLink.fromNodeIndex != UUID_NULL)
         {
-            inPosition = GetNode(m_currentLink.fromNodeIndex).lock()->GetOutputPosition(m_currentLink.fromOutputIndex, origin, zoom);
+            inPosition = FindNode(m_currentLink.fromNodeIndex)->GetOutputPosition(m_currentLink.fromOutputIndex, origin, zoom);
         }
         else if (m_currentLink.toNodeIndex != UUID_NULL)
         {
-            outPosition = GetNode(m_currentLink.toNodeIndex).lock()->GetInputPosition(m_currentLink.toInputIndex, origin, zoom);
+            outPosition = FindNode(m_currentLink.toNodeIndex)->GetInputPosition(m_currentLink.toInputIndex, origin, zoom);
         }
 
         drawList->AddLine(inPosition, outPosition, IM_COL32(255, 255, 255, 255), 3 * zoom);
@@ -479,46 +548,91 @@ void NodeManager::SelectNode(const NodeRef& node)
 
 void NodeManager::AddSelectedNode(const NodeRef& node)
 {
-    if (!node)
+    if (!node || !node->p_handle.IsValid())
         return;
-    m_selectedNodes.push_back(node);
+    m_selectedNodes.push_back(node->p_handle);
     node->p_selected = true;
+    SyncHotData(*node);
 }
 
 void NodeManager::RemoveSelectedNode(const NodeWeak& node)
 {
-    for (auto it = m_selectedNodes.begin(); it != m_selectedNodes.end(); it++)
+    NodeRef nodeRef = node.lock();
+    if (!nodeRef)
+        return;
+    auto it = std::ranges::find(m_selectedNodes, nodeRef->p_handle);
+    if (it == m_selectedNodes.end())
+        return;
+    nodeRef->p_selected = false;
+    SyncHotData(*nodeRef);
+    m_selectedNodes.erase(it);
+}
+
+void NodeManager::ClearSelectedNodes()
+{
+    for (const NodeHandle& handle : m_selectedNodes)
     {
-        if (it->lock() == node.lock())
+        if (Node* node = GetNode(handle))
         {
-            it->lock()->p_selected = false;
-            m_selectedNodes.erase(it);
-            return;
+            node->p_selected = false;
+            SyncHotData(*node);
         }
     }
+    m_selectedNodes.clear();
 }
 
-void NodeManager::ClearSelectedNodes()
+void NodeManager::SyncHotData(const Node& node)
 {
-    for (NodeRef& node : m_nodes | std::views::values)
+    const uint32_t index = m_nodes.GetDenseIndex(node.p_handle);
+    if (index == UINT32_MAX)
+        return;
+    const float sizeY = node.p_preview ? node.p_sizeWithPreview.y : node.p_size.y;
+    const bool geometryChanged = m_hotData.positionX[index] != node.p_position.x || m_hotData.positionY[index] != node.p_position.y
+        || m_hotData.sizeX[index] != node.p_size.x || m_hotData.sizeY[index] != sizeY;
+
+    m_hotData.positionX[index] = node.p_position.x;
+    m_hotData.positionY[index] = node.p_position.y;
+    m_hotData.sizeX[index] = node.p_size.x;
+    m_hotData.sizeY[index] = sizeY;
+    m_hotData.SetFlag(index, NodeHotData::Selected, node.p_selected);
+    if (geometryChanged)
     {
-        node->p_selected = false;
+        m_nodeGrid.Set(node.p_handle, m_hotData.GetMin(index), m_hotData.GetMax(index));
+        m_linkManager->UpdateLinkCurves(node.p_uuid);
     }
-    m_selectedNodes.clear();
 }
 
 NodeWeak NodeManager::GetNode(const UUID& uuid) const
 {
-    if (m_nodes.find(uuid) == m_nodes.end())
+    auto it = m_uuidToHandle.find(uuid);
+    if (it == m_uuidToHandle.end())
     {
         return {};
     }
-    return m_nodes.at(uuid);
+    return *m_nodes.Get(it->second);
+}
+
+Node* NodeManager::GetNode(const NodeHandle& handle) const
+{
+    const NodeRef* node = m_nodes.Get(handle);
+    return node ? node->get() : nullptr;
+}
+
+Node* NodeManager::FindNode(const UUID& uuid) const
+{
+    auto it = m_uuidToHandle.find(uuid);
+    return it != m_uuidToHandle.end() ? GetNode(it->second) : nullptr;
+}
+
+NodeHandle NodeManager::GetHandle(const UUID& uuid) const
+{
+    auto it = m_uuidToHandle.find(uuid);
+    return it != m_uuidToHandle.end() ? it->second : NodeHandle();
 }
 
 NodeWeak NodeManager::GetNodeWithTemplate(TemplateID templateID)
 {
-    for (auto& val : m_nodes | std::views::values)
+    for (auto& val : m_nodes.GetValues())
     {
         if (val->p_templateID == templateID)
         {
@@ -530,7 +644,7 @@ NodeWeak NodeManager::GetNodeWithTemplate(TemplateID templateID)
 
 NodeWeak NodeManager::GetNodeWithName(const std::string& name)
 {
-    for (auto& val : m_nodes | std::views::values)
+    for (auto& val : m_nodes.GetValues())
     {
         if (val->p_name == name)
         {
@@ -542,35 +656,56 @@ NodeWeak NodeManager::GetNodeWithName(const std::string& name)
 
 std::vector<NodeWeak> NodeManager::GetNodeConnectedTo(const UUID& uuid) const
 {
-    std::vector<NodeWeak> outputs;
-    NodeRef node = GetNode(uuid).lock();
-
-    auto linkManager = GetLinkManager();
+    const std::vector<NodeWeak>& order = GetEvaluationOrder(uuid);
+    // Without the node itself
+    return { order.begin(), order.end() - 1 };
+}
 
-    for (int i = 0; i < node->p_inputs.size(); i++)
+const std::vector<NodeWeak>& NodeManager::GetEvaluationOrder(const UUID& uuid) const
+{
+    if (m_evaluationOrdersVersion != m_linkManager->GetGraphVersion())
     {
-        LinkRef val = linkManager->GetLinkLinkedToInput(uuid, i).lock();
-        if (!val)
-            continue;
-        auto connectedNode = GetNode(val->fromNodeIndex);
-        outputs.push_back(connectedNode);
-        std::vector<NodeWeak> nodeConnectedTo = GetNodeConnectedTo(connectedNode.lock()->GetUUID());
-        outputs.insert(outputs.begin(), nodeConnectedTo.begin(), nodeConnectedTo.end());
+        m_evaluationOrders.clear();
+        m_evaluationOrdersVersion = m_linkManager->GetGraphVersion();
     }
 
-    return outputs;
+    auto [it, inserted] = m_evaluationOrders.try_emplace(uuid);
+    if (!inserted)
+        return it->second;
+
+    std::vector<UUID> upstream;
+    m_linkManager->GetTopologicalOrder().GetUpstream(uuid, upstream);
+    it->second.reserve(upstream.size());
+    for (const UUID& node : upstream)
+    {
+        it->second.push_back(GetNode(node));
+    }
+    return it->second;
 }
 
-std::vector<LinkWeakRef> NodeManager::GetLinkWithOutput(const UUID& uuid, const uint32_t index) const
+std::vector<LinkHandle> NodeManager::GetLinkWithOutput(const UUID& uuid, const uint32_t index) const
 {
-    return m_linkManager->GetLinksWithOutput(GetNode(uuid).lock()->GetOutput(index));
+    return m_linkManager->GetLinksWithOutput(FindNode(uuid)->GetOutput(index));
 }
 
 NodeWeak NodeManager::GetSelectedNode() const
 {
     if (m_selectedNodes.empty())
         return {};
-    return m_selectedNodes[0];
+    const NodeRef* node = m_nodes.Get(m_selectedNodes[0]);
+    return node ? *node : NodeWeak();
+}
+
+std::vector<NodeWeak> NodeManager::GetSelectedNodes() const
+{
+    std::vector<NodeWeak> selectedNodes;
+    selectedNodes.reserve(m_selectedNodes.size());
+    for (const NodeHandle& handle : m_selectedNodes)
+    {
+        if (const NodeRef* node = m_nodes.Get(handle))
+            selectedNodes.push_back(*node);
+    }
+    return selectedNodes;
 }
 
 bool NodeManager::CurrentLinkIsAlmostLinked() const
@@ -639,9 +774,9 @@ void NodeManager::LoadFromFile(const std::string& filePath)
 void NodeManager::Serialize(CppSer::Serializer& serializer) const
 {
     serializer << CppSer::Pair::BeginMap << "Nodes";
-    serializer << CppSer::Pair::Key << "Node Count" << CppSer::Pair::Value << m_nodes.size();
+    serializer << CppSer::Pair::Key << "Node Count" << CppSer::Pair::Value << m_nodes.Size();
     serializer << CppSer::Pair::BeginTab;
-    for (const NodeRef& node : m_nodes | std::views::values)
+    for (const NodeRef& node : m_nodes.GetValues())
     {
         node->Serialize(serializer);
     }
@@ -657,11 +792,11 @@ void NodeManager::SerializeSelectedNodes(CppSer::Serializer& serializer) const
     nodesToSerialize.reserve(m_selectedNodes.size());
     
     // Collect selected nodes with interaction enabled
-    for (const NodeWeak& node : m_selectedNodes)
+    for (const NodeHandle& handle : m_selectedNodes)
     {
-        if (auto ref = node.lock(); ref && ref->p_allowInteraction)
+        if (const NodeRef* ref = m_nodes.Get(handle); ref && (*ref)->p_allowInteraction)
         {
-            nodesToSerialize.push_back(ref);
+            nodesToSerialize.push_back(*ref);
         }
     }
 
@@ -683,22 +818,13 @@ void NodeManager::SerializeSelectedNodes(CppSer::Serializer& serializer) const
         nodeUUIDs.insert(node->GetUUID());
     }
 
-    // Collect unique links
-    std::vector<LinkRef> linkToSerialize;
-    std::unordered_set<LinkRef> uniqueLinks;
-
-    auto links = m_linkManager->GetLinks();
-    for (const NodeRef& node : nodesToSerialize)
+    // Collect the links between serialized nodes, each stored link is visited once
+    std::vector<Link> linkToSerialize;
+    for (const Link& link : m_linkManager->GetLinks())
     {
-        for (const LinkWeakRef& link : links)
+        if (nodeUUIDs.contains(link.fromNodeIndex) && nodeUUIDs.contains(link.toNodeIndex))
         {
-            if (auto linkPtr = link.lock();
-                nodeUUIDs.contains(linkPtr->fromNodeIndex) &&
-                nodeUUIDs.contains(linkPtr->toNodeIndex) &&
-                uniqueLinks.insert(linkPtr).second) // Insert only if unique
-            {
-                linkToSerialize.push_back(linkPtr);
-            }
+            linkToSerialize.push_back(link);
         }
     }
 
@@ -753,7 +879,18 @@ void NodeManager::Clean()
 {
     m_linkManager->Clean();
     m_selectedNodes.clear();
-    m_nodes.clear();
+    for (const NodeRef& node : m_nodes.GetValues())
+    {
+        node->p_handle = {};
+    }
+    m_nodes.Clear();
+    m_uuidToHandle.clear();
+    m_hotData.Clear();
+    m_nodeGrid.Clear();
+    m_uncomputedNodes.clear();
+    m_visibleNodes.clear();
+    m_hoveredNodes.clear();
+    m_evaluationOrders.clear();
     m_currentLink = Link();
     m_userInputState = UserInputState::None;
     m_selectionSquare = SelectionSquare();
@@ -45,41 +45,26 @@ bool NodeTemplateHandler::RunUnitTest(const NodeMethodInfo& info)
         inputNames[i] = inputName;
     }
 
-    auto formatList = node->GetFormatStrings();
+    const std::vector<std::string_view> arguments(inputNames.begin(), inputNames.end());
     for (int k = 0; k <  node->p_outputs.size(); k++)
     {
         std::string variableName = node->p_outputs[k]->name + "_" + std::to_string(k);
         std::string glslType = ShaderMaker::TypeToGLSLType(node->p_outputs[k]->type);
             
-        std::string thisContent = glslType + " " + variableName + " = ";
-        std::string toFormat = formatList[k];
-        std::string secondHalf = toFormat;
-        toFormat.clear();
-        for (int j = 0; j < node->p_inputs.size(); j++)
-        {
-            InputRef input = node->p_inputs[j];
-            size_t index = secondHalf.find_first_of("%") + 2;
-            if (index == std::string::npos)
-                break;
-            std::string firstHalf = secondHalf.substr(0, index);
-            if (index != std::string::npos)
-                secondHalf = secondHalf.substr(index);
-            auto parentVariableName =inputNames[j];
-            toFormat += FormatString(firstHalf, parentVariableName.c_str());
-        }
-        thisContent += toFormat + secondHalf + ";\n";
-
-        content += thisContent;
+        content += glslType + " " + variableName + " = ";
+        info.outputFormats[k]->Append(content, arguments);
+        content += ";\n";
     }
     content += "}\n";
-    bool success = shader->SetFragmentShaderContent(content);
+    // Goes through the program caches, a template already compiled by a previous session is not compiled again
+    bool success = shader->RecompileFragmentShader(content.c_str());
     if (!success)
     {
         std::cout << "Failed with node: " << node->p_name << std::endl;
         return false;
     }
     
-    return shader->Link();
+    return true;
 }
 
 void NodeTemplateHandler::Initialize()
@@ -359,6 +344,8 @@ void NodeTemplateHandler::Initialize()
             }
         }
     }
+    // Renaming changed the IDs of the duplicates
+    UpdateTemplateIndices();
     
 #ifdef _DEBUG
     RunUnitTests();
@@ -383,14 +370,28 @@ void NodeTemplateHandler::ComputeNodesSize()
 
 std::vector<std::string> NodeTemplateHandler::GetTemplateFormatStrings(TemplateID templateID)
 {
-    for (auto& m_templateNode : s_instance->m_templateNodes)
+    auto it = s_instance->m_templateIndices.find(templateID);
+    if (it == s_instance->m_templateIndices.end())
+        return {};
+    return s_instance->m_templateNodes[it->second].outputFormatStrings;
+}
+
+const std::vector<ShaderFormatRef>& NodeTemplateHandler::GetTemplateFormats(TemplateID templateID)
+{
+    static const std::vector<ShaderFormatRef> empty;
+    auto it = s_instance->m_templateIndices.find(templateID);
+    if (it == s_instance->m_templateIndices.end())
+        return empty;
+    return s_instance->m_templateNodes[it->second].outputFormats;
+}
+
+void NodeTemplateHandler::UpdateTemplateIndices()
+{
+    m_templateIndices.clear();
+    for (size_t i = 0; i < m_templateNodes.size(); i++)
     {
-        if (m_templateNode.node->p_templateID == templateID)
-        {
-            return m_templateNode.outputFormatStrings;
-        }
+        m_templateIndices[m_templateNodes[i].node->p_templateID] = i;
     }
-    return {};
 }
 
 void NodeTemplateHandler::AddTemplateNode(const NodeMethodInfo& info)
@@ -406,6 +407,14 @@ void NodeTemplateHandler::AddTemplateNode(const NodeMethodInfo& info)
     }
     info.node->p_templateID = TemplateIDFromString(name); 
     m_templateNodes.push_back(info);
+
+    NodeMethodInfo& addedInfo = m_templateNodes.back();
+    addedInfo.outputFormats.clear();
+    for (const std::string& format : addedInfo.outputFormatStrings)
+    {
+        addedInfo.outputFormats.push_back(std::make_shared<const ShaderFormat>(format));
+    }
+    m_templateIndices[info.node->p_templateID] = m_templateNodes.size() - 1;
 }
 
 TemplateID NodeTemplateHandler::TemplateIDFromString(const std::string& name)
@@ -0,0 +1,234 @@
+#include "NodeSystem/ShaderEvaluator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unordered_map>
+
+using ComponentFunction = float (*)(const float* x);
+using VectorFunction = bool (*)(const std::vector<const IRValue*>& x, Vec4f& result);
+
+static float Sign(float x)
+{
+    return static_cast<float>((x > 0.f) - (x < 0.f));
+}
+
+static float Length(const IRValue& value)
+{
+    float sum = 0.f;
+    for (uint32_t i = 0; i < ShaderEvaluator::GetComponentCount(value.type); i++)
+    {
+        sum += value.constant[i] * value.constant[i];
+    }
+    return std::sqrt(sum);
+}
+
+static const std::unordered_map<std::string, ComponentFunction>& GetComponentFunctions()
+{
+    static const std::unordered_map<std::string, ComponentFunction> functions =
+    {
+        { "%s", [](const float* x) { return x[0]; } },
+        { "%s + %s", [](const float* x) { return x[0] + x[1]; } },
+        { "%s - %s", [](const float* x) { return x[0] - x[1]; } },
+        { "%s * %s", [](const float* x) { return x[0] * x[1]; } },
+        { "%s / %s", [](const float* x) { return x[0] / x[1]; } },
+        { "1.0 - %s", [](const float* x) { return 1.f - x[0]; } },
+        { "abs(%s)", [](const float* x) { return std::abs(x[0]); } },
+        { "floor(%s)", [](const float* x) { return std::floor(x[0]); } },
+        { "ceil(%s)", [](const float* x) { return std::ceil(x[0]); } },
+        { "round(%s)", [](const float* x) { return std::round(x[0]); } },
+        { "sign(%s)", [](const float* x) { return Sign(x[0]); } },
+        { "sqrt(%s)", [](const float* x) { return std::sqrt(x[0]); } },
+        { "sin(%s)", [](const float* x) { return std::sin(x[0]); } },
+        { "cos(%s)", [](const float* x) { return std::cos(x[0]); } },
+        { "tan(%s)", [](const float* x) { return std::tan(x[0]); } },
+        { "asin(%s)", [](const float* x) { return std::asin(x[0]); } },
+        { "acos(%s)", [](const float* x) { return std::acos(x[0]); } },
+        { "atan(%s)", [](const float* x) { return std::atan(x[0]); } },
+        { "atan(%s, %s)", [](const float* x) { return std::atan2(x[0], x[1]); } },
+        { "max(%s, %s)", [](const float* x) { return std::max(x[0], x[1]); } },
+        { "min(%s, %s)", [](const float* x) { return std::min(x[0], x[1]); } },
+        { "clamp(%s, %s, %s)", [](const float* x) { return std::min(std::max(x[0], x[1]), x[2]); } },
+        { "clamp(%s, 0.0, 1.0)", [](const float* x) { return std::min(std::max(x[0], 0.f), 1.f); } },
+        { "mix(%s, %s, %s)", [](const float* x) { return x[0] * (1.f - x[2]) + x[1] * x[2]; } },
+        { "smoothstep(%s, %s, %s)", [](const float* x)
+            {
+                const float t = std::min(std::max((x[2] - x[0]) / (x[1] - x[0]), 0.f), 1.f);
+                return t * t * (3.f - 2.f * t);
+            } },
+        { "step(%s, %s)", [](const float* x) { return x[1] < x[0] ? 0.f : 1.f; } },
+        { "fract(%s)", [](const float* x) { return x[0] - std::floor(x[0]); } },
+        { "pow(%s, %s)", [](const float* x) { return std::pow(x[0], x[1]); } },
+        { "log(%s)", [](const float* x) { return std::log(x[0]); } },
+        { "exp(%s)", [](const float* x) { return std::exp(x[0]); } },
+        { "log2(%s)", [](const float* x) { return std::log2(x[0]); } },
+    };
+    return functions;
+}
+
+static const std::unordered_map<std::string, VectorFunction>& GetVectorFunctions()
+{
+    static const std::unordered_map<std::string, VectorFunction> functions =
+    {
+        { "dot(%s, %s)", [](const std::vector<const IRValue*>& x, Vec4f& result)
+            {
+                result = Vec4f(0.f);
+                for (uint32_t i = 0; i < ShaderEvaluator::GetComponentCount(x[0]->type); i++)
+                {
+                    result[0] += x[0]->constant[i] * x[1]->constant[i];
+                }
+                return true;
+            } },
+        { "length(%s)", [](const std::vector<const IRValue*>& x, Vec4f& result)
+            {
+                result = Vec4f(Length(*x[0]));
+                return true;
+            } },
+        { "distance(%s, %s)", [](const std::vector<const IRValue*>& x, Vec4f& result)
+            {
+                IRValue difference = *x[0];
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    difference.constant[i] -= x[1]->constant[i];
+                }
+                result = Vec4f(Length(difference));
+                return true;
+            } },
+        { "normalize(%s)", [](const std::vector<const IRValue*>& x, Vec4f& result)
+            {
+                const float length = Length(*x[0]);
+                if (length == 0.f)
+                    return false;
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    result[i] = x[0]->constant[i] / length;
+                }
+                return true;
+            } },
+        { "cross(%s, %s)", [](const std::vector<const IRValue*>& x, Vec4f& result)
+            {
+                const Vec4f& a = x[0]->constant;
+                const Vec4f& b = x[1]->constant;
+                result = Vec4f(a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0], 0.f);
+                return true;
+            } },
+        { "%s.x", [](const std::vector<const IRValue*>& x, Vec4f& result) { result = Vec4f(x[0]->constant[0]); return true; } },
+        { "%s.y", [](const std::vector<const IRValue*>& x, Vec4f& result) { result = Vec4f(x[0]->constant[1]); return true; } },
+        { "%s.z", [](const std::vector<const IRValue*>& x, Vec4f& result) { result = Vec4f(x[0]->constant[2]); return true; } },
+        { "%s.w", [](const std::vector<const IRValue*>& x, Vec4f& result) { result = Vec4f(x[0]->constant[3]); return true; } },
+    };
+    return functions;
+}
+
+bool ShaderEvaluator::Evaluate(const std::string& format, Type type, const std::vector<const IRValue*>& operands, Vec4f& result)
+{
+    // Only the operands consumed by the format take part, like when the format is applied
+    size_t argumentCount = 0;
+    for (size_t index = format.find("%s"); index != std::string::npos; index = format.find("%s", index + 2))
+    {
+        argumentCount++;
+    }
+    if (argumentCount > operands.size())
+        return false;
+
+    result = Vec4f(0.f);
+    bool evaluated = false;
+    if (auto it = GetComponentFunctions().find(format); it != GetComponentFunctions().end())
+    {
+        float arguments[4] = {};
+        for (uint32_t i = 0; i < GetComponentCount(type); i++)
+        {
+            for (size_t j = 0; j < argumentCount; j++)
+            {
+                const bool isScalar = GetComponentCount(operands[j]->type) == 1;
+                arguments[j] = operands[j]->constant[isScalar ? 0 : i];
+            }
+            result[i] = it->second(arguments);
+        }
+        evaluated = true;
+    }
+    else if (auto vectorIt = GetVectorFunctions().find(format); vectorIt != GetVectorFunctions().end())
+    {
+        evaluated = vectorIt->second(operands, result);
+    }
+    else if (format.starts_with("vec"))
+    {
+        evaluated = EvaluateConstructor(format, type, operands, result);
+    }
+
+    if (!evaluated)
+        return false;
+
+    // Only the used components have to be written as literals
+    for (uint32_t i = GetComponentCount(type); i < 4; i++)
+    {
+        result[i] = 0.f;
+    }
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        if (!std::isfinite(result[i]))
+            return false;
+    }
+    return true;
+}
+
+uint32_t ShaderEvaluator::GetComponentCount(Type type)
+{
+    switch (type)
+    {
+    case Type::Vector2:
+        return 2;
+    case Type::Vector3:
+        return 3;
+    case Type::Vector4:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+bool ShaderEvaluator::EvaluateConstructor(const std::string& format, Type type, const std::vector<const IRValue*>& operands, Vec4f& result)
+{
+    // vecN(...) : the components of the arguments are laid out in order, a single float fills every component
+    const size_t open = format.find('(');
+    if (open == std::string::npos || format.back() != ')')
+        return false;
+
+    std::vector<float> components;
+    size_t operandIndex = 0;
+    size_t start = open + 1;
+    while (start < format.size() - 1)
+    {
+        size_t end = format.find(", ", start);
+        if (end == std::string::npos)
+            end = format.size() - 1;
+        const std::string argument = format.substr(start, end - start);
+        if (argument == "%s")
+        {
+            const IRValue* operand = operands[operandIndex++];
+            for (uint32_t i = 0; i < GetComponentCount(operand->type); i++)
+            {
+                components.push_back(operand->constant[i]);
+            }
+        }
+        else
+        {
+            char* parseEnd = nullptr;
+            components.push_back(std::strtof(argument.c_str(), &parseEnd));
+            if (parseEnd != argument.c_str() + argument.size())
+                return false;
+        }
+        start = end + 2;
+    }
+
+    const uint32_t count = GetComponentCount(type);
+    if (components.size() == 1)
+        components.resize(count, components[0]);
+    if (components.size() < count)
+        return false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        result[i] = components[i];
+    }
+    return true;
+}
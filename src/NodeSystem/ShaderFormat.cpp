@@ -0,0 +1,23 @@
+#include "NodeSystem/ShaderFormat.h"
+
+ShaderFormat::ShaderFormat(std::string format) : m_format(std::move(format))
+{
+    size_t start = 0;
+    for (size_t index = m_format.find("%s"); index != std::string::npos; index = m_format.find("%s", start))
+    {
+        m_slices.push_back({ static_cast<uint32_t>(start), static_cast<uint32_t>(index - start) });
+        start = index + 2;
+    }
+    m_slices.push_back({ static_cast<uint32_t>(start), static_cast<uint32_t>(m_format.size() - start) });
+    m_hash = std::hash<std::string>{}(m_format);
+}
+
+void ShaderFormat::Append(std::string& output, const std::vector<std::string_view>& arguments) const
+{
+    output.append(m_format, m_slices[0].offset, m_slices[0].size);
+    for (size_t i = 1; i < m_slices.size(); i++)
+    {
+        output += i <= arguments.size() ? arguments[i - 1] : std::string_view("%s");
+        output.append(m_format, m_slices[i].offset, m_slices[i].size);
+    }
+}
@@ -0,0 +1,400 @@
+#include "NodeSystem/ShaderIR.h"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+#include "NodeSystem/CustomNode.h"
+#include "NodeSystem/LinkManager.h"
+#include "NodeSystem/NodeManager.h"
+#include "NodeSystem/NodeTemplateHandler.h"
+#include "NodeSystem/ParamNode.h"
+#include "NodeSystem/ShaderEvaluator.h"
+#include "NodeSystem/ShaderMaker.h"
+
+void ShaderIR::Build(NodeManager* manager, const NodeRef& endNode)
+{
+    Clear();
+    if (endNode == nullptr)
+        return;
+    this->endNode = endNode->GetUUID();
+
+    for (const NodeWeak& weak : manager->GetEvaluationOrder(endNode->GetUUID()))
+    {
+        if (NodeRef node = weak.lock())
+            AddNode(manager->GetLinkManager(), node);
+    }
+}
+
+void ShaderIR::BuildGraph(NodeManager* manager)
+{
+    Clear();
+    LinkManager* linkManager = manager->GetLinkManager();
+    const TopologicalOrder& order = linkManager->GetTopologicalOrder();
+
+    // Nodes without links can go anywhere, the linked ones follow the topological order
+    for (const NodeRef& node : manager->GetNodes())
+    {
+        if (node && !order.Contains(node->GetUUID()))
+            AddNode(linkManager, node);
+    }
+    order.ForEach([&](const UUID& uuid)
+    {
+        if (NodeRef node = manager->GetNode(uuid).lock())
+            AddNode(linkManager, node);
+    });
+}
+
+void ShaderIR::AddNode(LinkManager* linkManager, const NodeRef& node)
+{
+    const std::vector<InputRef>& inputs = node->GetInputs();
+    const std::vector<OutputRef>& outputs = node->GetOutputs();
+    IRNode& irNode = nodes[node->GetUUID()];
+
+    // Inputs are bound to the value of the linked output, or to their own value
+    irNode.inputs.reserve(inputs.size());
+    for (uint32_t i = 0; i < inputs.size(); i++)
+    {
+        const InputRef& input = inputs[i];
+        const Link* link = linkManager->GetLink(linkManager->GetLinkLinkedToInput(node->GetUUID(), i));
+        auto it = link ? nodes.find(link->fromNodeIndex) : nodes.end();
+        if (it != nodes.end() && link->fromOutputIndex < it->second.outputs.size())
+            irNode.inputs.push_back(it->second.outputs[link->fromOutputIndex]);
+        else if (uniformInputs)
+            irNode.inputs.push_back(AddUniform(node, i));
+        else
+            irNode.inputs.push_back(AddConstant(input->type, input->GetValue()));
+    }
+
+    IROp op = IROp::Template;
+    if (CustomNodeRef customNode = std::dynamic_pointer_cast<CustomNode>(node))
+    {
+        op = IROp::Custom;
+        customFunctions.push_back({ node->GetUUID(), customNode->GetFunctionNameAndArgs(), customNode->GetContent() });
+    }
+    else if (std::dynamic_pointer_cast<ParamNode>(node))
+    {
+        op = IROp::Param;
+    }
+
+    // Template formats are parsed once, the formats of params and custom nodes depend on the node
+    std::vector<ShaderFormatRef> nodeFormats;
+    const std::vector<ShaderFormatRef>* formats = &nodeFormats;
+    if (op == IROp::Template)
+    {
+        formats = &NodeTemplateHandler::GetTemplateFormats(node->GetTemplateID());
+    }
+    else
+    {
+        for (std::string& format : node->GetFormatStrings())
+        {
+            nodeFormats.push_back(std::make_shared<const ShaderFormat>(std::move(format)));
+        }
+    }
+    if (formats->size() < (op == IROp::Custom ? 1 : outputs.size()))
+    {
+        std::cout << "Missing shader format for node " << node->GetName() << '\n';
+        nodeFormats.resize(outputs.size() + 1, std::make_shared<const ShaderFormat>());
+        formats = &nodeFormats;
+    }
+
+    // The values of a node are contiguous
+    irNode.outputs.reserve(outputs.size());
+    for (uint32_t k = 0; k < outputs.size(); k++)
+    {
+        irNode.outputs.push_back(static_cast<IRValueID>(values.size()));
+        IRValue& value = values.emplace_back();
+        value.op = op;
+        value.type = outputs[k]->type;
+        value.templateID = node->GetTemplateID();
+        value.node = node->GetUUID();
+        value.output = k;
+        value.operands = irNode.inputs;
+        value.format = op == IROp::Custom ? (*formats)[0] : (*formats)[k];
+        value.name = ShaderMaker::GetOutputVariableName(node, k);
+    }
+}
+
+void ShaderIR::Clear()
+{
+    values.clear();
+    customFunctions.clear();
+    nodes.clear();
+    endNode = UUID_NULL;
+}
+
+IRValueID ShaderIR::GetResult(const UUID& node) const
+{
+    auto it = nodes.find(node);
+    if (it == nodes.end())
+        return c_invalidIRValue;
+
+    const IRNode& irNode = it->second;
+    if (!irNode.outputs.empty())
+        return irNode.outputs[0];
+    for (IRValueID input : irNode.inputs)
+    {
+        if (!IsConstant(input))
+            return input;
+    }
+    return irNode.inputs.empty() ? c_invalidIRValue : irNode.inputs[0];
+}
+
+std::vector<IRValueID> ShaderIR::GetRoots(const UUID& node) const
+{
+    std::vector<IRValueID> roots;
+    if (auto it = nodes.find(node); it != nodes.end())
+        roots = it->second.inputs;
+    if (IRValueID result = GetResult(node); result != c_invalidIRValue)
+        roots.push_back(result);
+    return roots;
+}
+
+void ShaderIR::MarkLive(const std::vector<IRValueID>& roots, std::vector<bool>& live) const
+{
+    live.assign(values.size(), false);
+    IRValueID last = 0;
+    for (IRValueID root : roots)
+    {
+        live[root] = true;
+        last = std::max(last, root + 1);
+    }
+
+    // Operands always come first, walking backward reaches every reader before what it reads.
+    // Nothing after the last root can be read
+    for (IRValueID first = last; first-- > 0;)
+    {
+        // Each node is handled once, from its first value
+        if (HasStatement(first) && first > 0 && HasStatement(first - 1) && values[first - 1].node == values[first].node)
+            continue;
+
+        const uint32_t count = GetValueCount(first);
+        if (values[first].op == IROp::Custom && std::ranges::any_of(live.begin() + first, live.begin() + first + count, [](bool isLive) { return isLive; }))
+        {
+            std::fill(live.begin() + first, live.begin() + first + count, true);
+        }
+        for (uint32_t k = 0; k < count; k++)
+        {
+            if (!live[first + k])
+                continue;
+            for (IRValueID operand : values[first + k].operands)
+            {
+                live[operand] = true;
+            }
+        }
+    }
+}
+
+IRValueID ShaderIR::AddConstant(Type type, const Vec4f& value)
+{
+    IRValue& constant = values.emplace_back();
+    constant.op = IROp::Constant;
+    constant.type = type;
+    constant.constant = value;
+    return static_cast<IRValueID>(values.size() - 1);
+}
+
+IRValueID ShaderIR::AddUniform(const NodeRef& node, uint32_t index)
+{
+    const InputRef& input = node->GetInputs()[index];
+    IRValue& uniform = values.emplace_back();
+    uniform.op = IROp::Uniform;
+    uniform.type = input->type;
+    uniform.node = node->GetUUID();
+    uniform.output = index;
+    uniform.name = ShaderMaker::GetInputUniformName(node, index);
+    uniform.input = input;
+    return static_cast<IRValueID>(values.size() - 1);
+}
+
+uint32_t ShaderIR::GetValueCount(IRValueID first) const
+{
+    if (!HasStatement(first))
+        return 1;
+    uint32_t count = 1;
+    while (first + count < values.size() && HasStatement(first + count) && values[first + count].node == values[first].node)
+    {
+        count++;
+    }
+    return count;
+}
+
+void ShaderIR::FoldConstants()
+{
+    std::vector<const IRValue*> operands;
+    std::vector<Vec4f> results;
+    for (IRValueID id = 0; id < values.size();)
+    {
+        const uint32_t count = GetValueCount(id);
+        const IRValue& first = values[id];
+        if (first.op == IROp::Template && std::ranges::all_of(first.operands, [this](IRValueID operand) { return IsConstant(operand); }))
+        {
+            operands.clear();
+            for (IRValueID operand : first.operands)
+            {
+                operands.push_back(&values[operand]);
+            }
+
+            // A node is folded with all its outputs or not at all, its values stay contiguous
+            results.resize(count);
+            bool folded = true;
+            for (uint32_t k = 0; k < count && folded; k++)
+            {
+                folded = ShaderEvaluator::Evaluate(values[id + k].format->GetString(), values[id + k].type, operands, results[k]);
+            }
+            if (folded)
+            {
+                for (uint32_t k = 0; k < count; k++)
+                {
+                    IRValue& value = values[id + k];
+                    value.op = IROp::Constant;
+                    value.operands.clear();
+                    value.constant = results[k];
+                }
+            }
+        }
+        id += count;
+    }
+}
+
+void ShaderIR::EliminateCommonSubexpressions()
+{
+    std::vector<IRValueID> replacements(values.size());
+    std::unordered_map<uint64_t, std::vector<IRValueID>> computations;
+
+    for (IRValueID id = 0; id < values.size();)
+    {
+        const uint32_t count = GetValueCount(id);
+        // Operands come first, they already point to the kept values
+        for (uint32_t k = 0; k < count; k++)
+        {
+            for (IRValueID& operand : values[id + k].operands)
+            {
+                operand = replacements[operand];
+            }
+        }
+
+        IRValueID kept = id;
+        // Custom functions are named after their node, two custom nodes never share a call.
+        // Each uniform is read from its own input
+        if (values[id].op != IROp::Custom && values[id].op != IROp::Uniform)
+        {
+            std::vector<IRValueID>& candidates = computations[HashComputation(id)];
+            for (IRValueID candidate : candidates)
+            {
+                if (IsSameComputation(candidate, id))
+                {
+                    kept = candidate;
+                    break;
+                }
+            }
+            if (kept == id)
+                candidates.push_back(id);
+        }
+
+        for (uint32_t k = 0; k < count; k++)
+        {
+            replacements[id + k] = kept + k;
+        }
+        id += count;
+    }
+
+    Compact(replacements);
+}
+
+void ShaderIR::EliminateDeadValues()
+{
+    std::vector<bool> live;
+    MarkLive(GetRoots(endNode), live);
+
+    std::vector<IRValueID> replacements(values.size());
+    for (IRValueID id = 0; id < values.size(); id++)
+    {
+        replacements[id] = live[id] ? id : c_invalidIRValue;
+    }
+    Compact(replacements);
+}
+
+uint64_t ShaderIR::HashComputation(IRValueID first) const
+{
+    const IRValue& value = values[first];
+    uint64_t hash = static_cast<uint64_t>(value.op);
+    HashCombine(hash, value.templateID);
+    HashCombine(hash, static_cast<uint64_t>(value.type));
+    for (IRValueID operand : value.operands)
+    {
+        HashCombine(hash, operand);
+    }
+    if (value.op == IROp::Constant)
+    {
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            HashCombine(hash, std::bit_cast<uint32_t>(value.constant[i]));
+        }
+    }
+    else
+    {
+        HashCombine(hash, value.format->GetHash());
+    }
+    return hash;
+}
+
+bool ShaderIR::IsSameComputation(IRValueID a, IRValueID b) const
+{
+    const uint32_t count = GetValueCount(a);
+    if (count != GetValueCount(b))
+        return false;
+
+    const IRValue& valueA = values[a];
+    const IRValue& valueB = values[b];
+    if (valueA.op != valueB.op || valueA.templateID != valueB.templateID || valueA.operands != valueB.operands)
+        return false;
+
+    if (valueA.op == IROp::Constant)
+    {
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            if (std::bit_cast<uint32_t>(valueA.constant[i]) != std::bit_cast<uint32_t>(valueB.constant[i]))
+                return false;
+        }
+        return valueA.type == valueB.type;
+    }
+
+    for (uint32_t k = 0; k < count; k++)
+    {
+        if (values[a + k].type != values[b + k].type || !(*values[a + k].format == *values[b + k].format))
+            return false;
+    }
+    return true;
+}
+
+void ShaderIR::Compact(const std::vector<IRValueID>& replacements)
+{
+    std::vector<IRValueID> newIDs(values.size(), c_invalidIRValue);
+    std::vector<IRValue> keptValues;
+    keptValues.reserve(values.size());
+    for (IRValueID id = 0; id < values.size(); id++)
+    {
+        if (replacements[id] != id)
+            continue;
+        newIDs[id] = static_cast<IRValueID>(keptValues.size());
+        keptValues.push_back(std::move(values[id]));
+    }
+
+    values = std::move(keptValues);
+
+    auto remap = [&](IRValueID& id)
+    {
+        if (id != c_invalidIRValue)
+            id = replacements[id] == c_invalidIRValue ? c_invalidIRValue : newIDs[replacements[id]];
+    };
+    for (IRValue& value : values)
+    {
+        std::ranges::for_each(value.operands, remap);
+    }
+    for (auto& [uuid, node] : nodes)
+    {
+        std::ranges::for_each(node.inputs, remap);
+        std::ranges::for_each(node.outputs, remap);
+    }
+}
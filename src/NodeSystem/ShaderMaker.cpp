@@ -1,53 +1,16 @@
 ﻿#include "NodeSystem/ShaderMaker.h"
 
+#include <bit>
+#include <cassert>
+#include <charconv>
 #include <fstream>
 #include <ranges>
 
 #include "NodeWindow.h"
-#include "NodeSystem/CustomNode.h"
 #include "NodeSystem/NodeTemplateHandler.h"
+#include "NodeSystem/ShaderSimplifier.h"
 #include "Render/Framebuffer.h"
-
-void ShaderMaker::FormatWithType(std::string& toFormat, InputRef input, std::string firstHalf)
-{
-    switch (input->type)
-    {
-    case Type::Float:
-        {
-            float value = input->GetValue<float>();
-            toFormat += FormatString(firstHalf, value);
-            break;
-        }
-    case Type::Int:
-        {
-            int valueInt = input->GetValue<int>();
-            toFormat += FormatString(firstHalf, valueInt);
-            break;
-        }
-    case Type::Bool:
-        {
-            bool valueBool = input->GetValue<bool>();
-            toFormat += FormatString(firstHalf, valueBool);
-            break;
-        }
-    case Type::Vector2:
-        {
-            Vec2f valueVec2 = input->GetValue<Vec2f>();
-            toFormat += FormatString(firstHalf, valueVec2.x, valueVec2.y);
-            break;
-        }
-    case Type::Vector3:
-        {
-            Vec3f valueVec3 = input->GetValue<Vec3f>();
-            toFormat += FormatString(firstHalf, valueVec3.x, valueVec3.y, valueVec3.z);
-            break;
-        }
-    default:
-        {
-            break;
-        }
-    }
-}
+#include "WorkerPool.h"
 
 void ShaderMaker::CleanString(std::string& name) {
     for (char& c : name) {
@@ -61,85 +24,47 @@ void ShaderMaker::CleanString(std::string& name) {
     name.erase(std::remove(name.begin(), name.end(), '\0'), name.end());
 }
 
-void ShaderMaker::FillFunctionList(NodeManager* manager, NodeRef firstNode)
-{
-    FillRecurrence(manager, firstNode);
-}
-
-void ShaderMaker::FillRecurrence(NodeManager* manager, const NodeRef& node)
+void ShaderMaker::DoWork(NodeManager* manager)
 {
-    if (node == nullptr) return;
-
-    auto linkManager = manager->GetLinkManager();
+    BuildGraphIR(manager);
 
-    // Recursively process connected nodes (children) first
-    for (int i = 0; i < node->p_inputs.size(); i++)
+    std::vector<NodeRef> previews;
+    for (const NodeRef& node : manager->GetNodes())
     {
-        LinkRef link = linkManager->GetLinkLinkedToInput(node->GetUUID(), i).lock();
-        if (link == nullptr)
-            continue;
-
-        NodeRef childNode = manager->GetNode(link->fromNodeIndex).lock();
-        if (childNode == nullptr)
-            continue;
-
-        FillRecurrence(manager, childNode);
+        if (node && node->p_preview)
+            previews.push_back(node);
     }
 
-    // Process the current node after all its children
-    FuncStruct& funcStruct = m_functions[node->p_uuid];
-    funcStruct.debugName = node->GetName();
-
-    for (int j = 0; j < node->p_outputs.size(); j++)
+    std::vector<std::vector<bool>> liveValues(previews.size());
+    WorkerPool::GetInstance().ParallelFor(static_cast<uint32_t>(previews.size()), [&](uint32_t i)
     {
-        std::string variableName = GetOutputVariableName(node, j);
-        funcStruct.outputs.push_back(variableName);
-    }
+        m_ir.MarkLive(m_ir.GetRoots(previews[i]->p_uuid), liveValues[i]);
+    });
 
-    // Gather input connections
-    for (int i = 0; i < node->p_inputs.size(); i++)
+    // Every snippet read by a preview is up to date before the shaders are written
+    std::vector<bool> live(m_ir.values.size(), false);
+    for (const std::vector<bool>& previewLive : liveValues)
     {
-        LinkRef link = linkManager->GetLinkLinkedToInput(node->GetUUID(), i).lock();
-        if (link == nullptr)
-        {
-            funcStruct.inputs.emplace_back("");
-            continue;
-        }
-
-        auto fromNode = manager->GetNode(link->fromNodeIndex).lock();
-        if (fromNode == nullptr)
+        for (size_t id = 0; id < live.size(); id++)
         {
-            funcStruct.inputs.emplace_back("");
-            continue;
+            live[id] = live[id] || previewLive[id];
         }
-
-        FuncStruct& parentFuncStruct = m_functions[fromNode->p_uuid];
-        auto inputName = parentFuncStruct.outputs[link->fromOutputIndex];
-        funcStruct.inputs.push_back(inputName);
     }
+    UpdateSnippets(live);
 
-    // Add the current node to the serialization list
-    m_nodesToSerialize.push_back(node);
-}
-
-
-void ShaderMaker::DoWork(NodeManager* manager)
-{    
-    auto endNode = manager->GetNodeWithName("Material").lock();
-    FillFunctionList(manager, endNode);
-
-    std::unordered_map<UUID, FuncStruct> functionList = m_functions;
-
-    for (NodeRef& node : std::views::values(manager->m_nodes))
+    std::vector<std::string> contents(previews.size());
+    std::vector<std::vector<ShaderUniform>> uniforms(previews.size());
+    WorkerPool::GetInstance().ParallelFor(static_cast<uint32_t>(previews.size()), [&](uint32_t i)
     {
-        if (!node || !node->p_preview)
-            continue;
-        std::string content;
-        
-        CreateFragmentShader(content, manager, node);
+        WriteFragmentShader(contents[i], previews[i]->p_uuid, liveValues[i], &uniforms[i]);
+    });
 
-        node->m_shader->RecompileFragmentShader(content.c_str());
+    // Nothing waits for the driver, the previews keep their program until the new one is linked
+    for (size_t i = 0; i < previews.size(); i++)
+    {
+        previews[i]->m_shader->SubmitFragmentShader(contents[i].c_str(), std::move(uniforms[i]));
     }
+    PruneSnippets(manager);
 }
 
 void ShaderMaker::CreateFragmentShader(std::string& content, NodeManager* manager)
@@ -152,175 +77,674 @@ void ShaderMaker::CreateFragmentShader(std::string& content, NodeManager* manage
 
 void ShaderMaker::CreateFragmentShader(const std::filesystem::path& path, NodeManager* manager)
 {
+    // Nothing sets the uniforms of an exported file, its values are written as literals
+    if (GetUniformInputs())
+    {
+        ShaderMaker().CreateFragmentShader(path, manager);
+        return;
+    }
+
     std::string content;
-    CreateFragmentShader(content, manager);
+    CreateFragmentShader(content, manager, manager->GetNodeWithName("Material").lock(), true);
 
     std::ofstream file(path, std::ios::out | std::ios::trunc);
     file << content;
     file.close();
 }
 
-void ShaderMaker::CreateFragmentShader(std::string& content, NodeManager* manager, const NodeRef& endNode)
+void ShaderMaker::CreateFragmentShader(std::string& content, NodeManager* manager, const NodeRef& endNode, bool exported)
 {
     content.clear();
+    if (endNode == nullptr)
+        return;
+
+    BuildIR(manager, endNode);
+    std::vector<bool> live;
+    m_ir.MarkLive(m_ir.GetRoots(endNode->p_uuid), live);
+    UpdateSnippets(live);
+    WriteFragmentShader(content, endNode->p_uuid, live, nullptr, exported);
+}
+
+void ShaderMaker::AssembleFragmentShader(std::string& content, const UUID& endNode, std::vector<ShaderUniform>* uniforms)
+{
+    std::vector<bool> live;
+    m_ir.MarkLive(m_ir.GetRoots(endNode), live);
+    UpdateSnippets(live);
+    WriteFragmentShader(content, endNode, live, uniforms);
+}
+
+void ShaderMaker::WriteFragmentShader(std::string& content, const UUID& endNode, const std::vector<bool>& live, std::vector<ShaderUniform>* uniforms, bool exported) const
+{
+    content.clear();
+    content += "#version 330 core\nin vec2 TexCoords;\n";
+    // Only the editor binds a buffer to the globals block, Shader::Use also sets a plain Time uniform
+    if (exported)
+        content += "uniform float Time;\n";
+    else
+        content += "layout(std140) uniform " + std::string(c_globalsBlockName) + "\n{\n    float Time;\n};\n";
+    content += "out vec4 FragColor;\n";
+
+    // The uniforms are members of one block, filled with a single buffer upload each frame
+    if (uniforms)
+        uniforms->clear();
+    std::string members;
+    for (IRValueID id = 0; id < m_ir.values.size(); id++)
+    {
+        const IRValue& value = m_ir.values[id];
+        if (value.op != IROp::Uniform || !live[id])
+            continue;
+        members += "    " + TypeToGLSLType(value.type) + " " + value.name + ";\n";
+        if (uniforms)
+            uniforms->push_back({ value.name, value.input });
+    }
+    // A block cannot be empty
+    if (!members.empty())
+        content += "layout(std140) uniform " + std::string(c_parametersBlockName) + "\n{\n" + members + "};\n";
+
+    // A custom node writes all its outputs with one call, its function is needed as soon as one is live
+    for (const IRCustomFunction& function : m_ir.customFunctions)
+    {
+        const std::vector<IRValueID>& outputs = m_ir.nodes.at(function.node).outputs;
+        if (std::ranges::any_of(outputs, [&live](IRValueID id) { return id != c_invalidIRValue && live[id]; }))
+            content += function.content;
+    }
+
+    content += "void main()\n{\n";
+
+    AppendSnippets(content, live);
+
+    content += "\n// Output to screen\n";
+    content += "FragColor = " + GetOutputColor(m_ir.GetResult(endNode)) + ";\n}\n";
+}
+
+void ShaderMaker::CreateShaderToyShader(NodeManager* manager)
+{
+    // Nothing sets the uniforms of an exported shader, its values are written as literals
+    if (GetUniformInputs())
+    {
+        ShaderMaker().CreateShaderToyShader(manager);
+        return;
+    }
+
+    // Get all nodes connected to the end node
+    NodeRef endNode = manager->GetNodeWithName("Material").lock();
+    if (endNode == nullptr)
+        return;
+
+    BuildIR(manager, endNode);
+    std::vector<bool> live(m_ir.values.size(), true);
+
+    std::string content;
+    for (const IRCustomFunction& function : m_ir.customFunctions)
+    {
+        content += function.declaration + "\n{\n";
+        content += function.content + "\n}\n";
+    }
+
+    content += "void mainImage( out vec4 fragColor, in vec2 fragCoord )\n{\n// Normalized pixel coordinates (from 0 to 1)\nvec2 uv = fragCoord/iResolution.xy;\n";
+
+    UpdateSnippets(live);
+    AppendSnippets(content, live);
+
+    content += "\n// Output to screen\nfragColor = " + GetOutputColor(m_ir.GetResult(endNode->p_uuid)) + ";\n}\n";
     
-    FillFunctionList(manager, endNode);
+    // TODO
+    ImGui::SetClipboardText(content.c_str());
 
-    content += "#version 330 core\nin vec2 TexCoords;\nuniform float Time;\nout vec4 FragColor;\n";
+    std::cout << content;
+}
 
-    std::set<UUID> customNodesDone;
-    for (const auto& currentNode : m_nodesToSerialize)
+void ShaderMaker::BuildIR(NodeManager* manager, const NodeRef& endNode)
+{
+    m_ir.Build(manager, endNode);
+    m_ir.FoldConstants();
+    ShaderSimplifier::Simplify(m_ir);
+    m_ir.EliminateCommonSubexpressions();
+    m_ir.EliminateDeadValues();
+}
+
+void ShaderMaker::BuildGraphIR(NodeManager* manager)
+{
+    m_ir.BuildGraph(manager);
+    m_ir.FoldConstants();
+    ShaderSimplifier::Simplify(m_ir);
+    m_ir.EliminateCommonSubexpressions();
+}
+
+std::string ShaderMaker::GetOperandString(IRValueID id) const
+{
+    const IRValue& value = m_ir.values[id];
+    if (value.op == IROp::Constant)
+        return GetValueAsString(value.type, value.constant);
+    return value.name;
+}
+
+// The statements of a node are emitted with its first value, its outputs may have been removed
+static bool IsNodeLive(const ShaderIR& ir, IRValueID first, const std::vector<bool>& live)
+{
+    return ir.HasStatement(first) && std::any_of(live.begin() + first, live.begin() + first + ir.GetValueCount(first), [](bool isLive) { return isLive; });
+}
+
+void ShaderMaker::UpdateSnippets(const std::vector<bool>& live)
+{
+    // The map is only changed here, the workers each write the code of their own snippet
+    std::vector<std::pair<IRValueID, ShaderSnippet*>> staleSnippets;
+    for (IRValueID id = 0; id < m_ir.values.size(); id += m_ir.GetValueCount(id))
     {
-        if (CustomNodeRef customNode = std::dynamic_pointer_cast<CustomNode>(currentNode.lock()))
+        if (!IsNodeLive(m_ir, id, live))
+            continue;
+
+        const uint64_t key = GetSnippetKey(id);
+        ShaderSnippet& snippet = m_snippets[m_ir.values[id].node];
+        if (snippet.code.empty() || snippet.key != key)
         {
-            if (customNodesDone.contains(customNode->p_uuid))
-                continue;
-            customNodesDone.insert(customNode->p_uuid);
-            content += customNode->GetContent();
+            snippet.key = key;
+            staleSnippets.emplace_back(id, &snippet);
         }
     }
 
-    content += "void main()\n{\n";
-    
-    auto templateList = NodeTemplateHandler::GetInstance()->GetTemplates();
-        
-    SerializeFunctions(manager, endNode, content);
+    WorkerPool::GetInstance().ParallelFor(static_cast<uint32_t>(staleSnippets.size()), [&](uint32_t i)
+    {
+        auto& [first, snippet] = staleSnippets[i];
+        snippet->code.clear();
+        EmitNode(first, snippet->code);
+    });
+    m_emittedSnippetCount += static_cast<uint32_t>(staleSnippets.size());
+}
 
-    FuncStruct& funcStruct = m_functions[endNode->p_uuid];
-    
-    content += endNode->ToShader(this, funcStruct);     
+void ShaderMaker::AppendSnippets(std::string& content, const std::vector<bool>& live) const
+{
+    for (IRValueID id = 0; id < m_ir.values.size(); id += m_ir.GetValueCount(id))
+    {
+        if (IsNodeLive(m_ir, id, live))
+            content += m_snippets.at(m_ir.values[id].node).code;
+    }
+}
 
-    content += "\n// Output to screen\n";
-    if (!endNode->GetOutputs().empty())
+uint64_t ShaderMaker::GetSnippetKey(IRValueID first) const
+{
+    const IRValue& firstValue = m_ir.values[first];
+    uint64_t key = static_cast<uint64_t>(firstValue.op);
+    HashCombine(key, firstValue.templateID);
+
+    // A linked input only depends on the name of the upstream value, not on how it is computed
+    for (IRValueID operand : firstValue.operands)
     {
-        auto output = endNode->GetOutputs()[0];
-        switch (output->type)
+        const IRValue& value = m_ir.values[operand];
+        HashCombine(key, static_cast<uint64_t>(value.type));
+        if (value.op == IROp::Constant)
+        {
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                HashCombine(key, std::bit_cast<uint32_t>(value.constant[i]));
+            }
+        }
+        else
         {
-        case Type::Float:
-        case Type::Int:
-        case Type::Bool:
-            content += "FragColor = vec4(" + GetOutputVariableName(endNode, 0) + ", 0.0, 0.0, 1.0);\n}\n";
-            break;
-        case Type::Vector2:
-            content += "FragColor = vec4(" + GetOutputVariableName(endNode, 0) + ", 0.0, 1.0);\n}\n";
-            break;
-        case Type::Vector3:
-            content += "FragColor = vec4(" + GetOutputVariableName(endNode, 0) + ", 1.0);\n}\n";
-            break;
-        default: ;
+            HashCombine(key, std::hash<std::string>{}(value.name));
         }
     }
-    else
+
+    for (IRValueID id = first; id < first + m_ir.GetValueCount(first); id++)
+    {
+        const IRValue& value = m_ir.values[id];
+        HashCombine(key, static_cast<uint64_t>(value.type));
+        HashCombine(key, value.format->GetHash());
+        HashCombine(key, std::hash<std::string>{}(value.name));
+    }
+    return key;
+}
+
+void ShaderMaker::EmitNode(IRValueID first, std::string& code) const
+{
+    const IRValue& firstValue = m_ir.values[first];
+
+    // Arguments point to the names in the IR, only the literals are built
+    std::vector<std::string> literals;
+    literals.reserve(firstValue.operands.size());
+    std::vector<std::string_view> arguments;
+    arguments.reserve(firstValue.operands.size() + m_ir.GetValueCount(first));
+    for (IRValueID operand : firstValue.operands)
     {
-        content += "FragColor = vec4(";
-        std::vector<LinkWeakRef> links = endNode->GetLinks();
-        std::string outputName;
-        if (links.empty())
+        const IRValue& value = m_ir.values[operand];
+        if (value.op == IROp::Constant)
         {
-            outputName = GetValueAsString(endNode->GetInput(0));
+            literals.push_back(GetValueAsString(value.type, value.constant));
+            arguments.push_back(literals.back());
         }
         else
         {
-            Ref<Link> firstLink = links[0].lock();
-            outputName = m_functions[firstLink->fromNodeIndex].outputs[firstLink->fromOutputIndex];
+            arguments.push_back(value.name);
         }
-        content += outputName + ", 1.0);\n}\n";
     }
-    
-    m_allVariableNames.clear();
-    m_functions.clear();
-    m_variablesNames.clear();
-    m_nodesToSerialize.clear();
+
+    for (IRValueID id = first; id < first + m_ir.GetValueCount(first); id++)
+    {
+        const IRValue& value = m_ir.values[id];
+        code += TypeToGLSLType(value.type);
+        code += ' ';
+        code += value.name;
+        if (value.op != IROp::Custom)
+        {
+            code += " = ";
+            value.format->Append(code, arguments);
+            code += ";\n";
+            continue;
+        }
+        // The outputs of a custom node are declared, then written by one call
+        code += ";\n";
+        arguments.push_back(value.name);
+    }
+
+    if (firstValue.op == IROp::Custom)
+    {
+        firstValue.format->Append(code, arguments);
+        code += ";\n";
+    }
 }
 
-void ShaderMaker::CreateShaderToyShader(NodeManager* manager)
+void ShaderMaker::PruneSnippets(NodeManager* manager)
 {
-    // Get all nodes connected to the end node
-    NodeRef endNode = manager->GetNodeWithName("Material").lock();
+    std::erase_if(m_snippets, [manager](const auto& pair) { return manager->GetNode(pair.first).expired(); });
+}
 
-    TemplateList& templateList = NodeTemplateHandler::GetInstance()->GetTemplates();
-    
-    std::string content;
+std::string ShaderMaker::GetOutputColor(IRValueID result) const
+{
+    if (result == c_invalidIRValue)
+        return "vec4(0.0, 0.0, 0.0, 1.0)";
+
+    const std::string color = GetOperandString(result);
+    switch (m_ir.values[result].type)
+    {
+    case Type::Float:
+    case Type::Int:
+    case Type::Bool:
+        return "vec4(" + color + ", 0.0, 0.0, 1.0)";
+    case Type::Vector2:
+        return "vec4(" + color + ", 0.0, 1.0)";
+    case Type::Vector3:
+        return "vec4(" + color + ", 1.0)";
+    case Type::Vector4:
+        return color;
+    default:
+        return "vec4(0.0, 0.0, 0.0, 1.0)";
+    }
+}
+
+// Graph with the Material end node that each test fills
+struct ShaderTestGraph
+{
+    NodeManager manager = NodeManager(nullptr);
+    NodeRef endNode = manager.GetNodeWithName("Material").lock();
+
+    NodeRef AddNode(const std::string& templateName)
+    {
+        NodeRef node = NodeTemplateHandler::CreateFromTemplateName(templateName);
+        manager.AddNode(node);
+        return node;
+    }
+
+    void Link(const NodeRef& from, uint32_t output, const NodeRef& to, uint32_t input)
+    {
+        manager.GetLinkManager()->CreateLink(from, output, to, input);
+    }
+};
 
-    FillFunctionList(manager, endNode);
+// Each node of the lattice takes its two inputs from the previous layer
+constexpr uint32_t c_latticeWidth = 3;
+constexpr uint32_t c_latticeDepth = 64;
 
-    std::set<UUID> customNodesDone;
-    for (const auto& currentNode : m_nodesToSerialize)
+// Deep lattice where the paths to a node grow exponentially with the depth, returns the first node of the first layer
+static NodeRef BuildLattice(ShaderTestGraph& graph)
+{
+    // Every source reads the coordinates so nothing can be folded
+    NodeRef texCoords = graph.AddNode("TexCoords");
+    NodeRef toVector3 = graph.AddNode("To Vector3 (Vector2)");
+    graph.Link(texCoords, 0, toVector3, 0);
+
+    NodeRef firstNode;
+    std::vector<NodeRef> previousLayer;
+    for (uint32_t layer = 0; layer < c_latticeDepth; layer++)
     {
-        if (CustomNodeRef customNode = std::dynamic_pointer_cast<CustomNode>(currentNode.lock()))
+        std::vector<NodeRef> currentLayer;
+        for (uint32_t i = 0; i < c_latticeWidth; i++)
         {
-            if (customNodesDone.contains(customNode->p_uuid))
-                continue;
-            customNodesDone.insert(customNode->p_uuid);
-            content += "void " + customNode->GetFunctionName() + "(";
-            for (const auto& input : customNode->p_inputs)
+            NodeRef node = graph.AddNode("Add (Vector3)");
+            if (!previousLayer.empty())
             {
-                content += "in " + TypeToGLSLType(input->type) + " " + input->name + ", ";
+                graph.Link(previousLayer[i], 0, node, 0);
+                graph.Link(previousLayer[(i + 1) % c_latticeWidth], 0, node, 1);
             }
-            for (const auto& output : customNode->p_outputs)
+            else
             {
-                content += "out " + TypeToGLSLType(output->type) + " " + output->name + ", ";
+                // Distinct sources, so no layer computes the same thing twice
+                node->GetInput(0)->SetValue(Vec3f(10.f + i, 0.f, 0.f));
+                graph.Link(toVector3, 0, node, 1);
             }
-            content.erase(content.end() - 2, content.end());
-            content += ")\n{\n";
-            content += customNode->GetContent() + "\n}\n";
+            currentLayer.push_back(node);
         }
+        if (firstNode == nullptr)
+            firstNode = currentLayer[0];
+        previousLayer = std::move(currentLayer);
     }
+    graph.Link(previousLayer[0], 0, graph.endNode, 0);
+    return firstNode;
+}
 
-    content += "void mainImage( out vec4 fragColor, in vec2 fragCoord )\n{\n// Normalized pixel coordinates (from 0 to 1)\nvec2 uv = fragCoord/iResolution.xy;\n";
-    
-    SerializeFunctions(manager, endNode, content);
-    content += "\n// Output to screen\nfragColor = vec4(";
-    auto firstLink = endNode->GetLinks()[0].lock();
-    auto outputName = m_functions[firstLink->fromNodeIndex].outputs[firstLink->fromOutputIndex];
-    content += outputName + ", 1.0);\n}\n";
-    
-    // TODO
-    ImGui::SetClipboardText(content.c_str());
+void ShaderMaker::RunUnitTests()
+{
+    TestIRBuild();
+    TestSnippetCache();
+    TestGraphPreview();
+    TestUniformInputs();
+    TestCommonSubexpressions();
+    TestConstantFolding();
+    TestSimplification();
+    TestShaderFormat();
+}
 
-    std::cout << content;
+void ShaderMaker::TestIRBuild()
+{
+    ShaderTestGraph graph;
+    BuildLattice(graph);
+
+    // One value per output of each node, operands always come first
+    ShaderIR ir;
+    ir.Build(&graph.manager, graph.endNode);
+    std::unordered_map<UUID, uint32_t> valueCounts;
+    for (IRValueID id = 0; id < ir.values.size(); id++)
+    {
+        const IRValue& value = ir.values[id];
+        for (IRValueID operand : value.operands)
+        {
+            assert(operand < id);
+        }
+        if (value.op != IROp::Constant)
+            valueCounts[value.node]++;
+    }
+    for (const auto& [uuid, count] : valueCounts)
+    {
+        assert(count == graph.manager.GetNode(uuid).lock()->p_outputs.size());
+    }
+    // The end node has no output, it only binds its inputs
+    assert(valueCounts.size() == graph.manager.GetNodeConnectedTo(graph.endNode->p_uuid).size());
+    const std::vector<IRValueID>& endInputs = ir.nodes.at(graph.endNode->p_uuid).inputs;
+    assert(endInputs.size() == graph.endNode->p_inputs.size() && ir.GetResult(graph.endNode->p_uuid) == endInputs[0]);
+
+    // Each variable is declared once
+    std::string content;
+    ShaderMaker().CreateFragmentShader(content, &graph.manager, graph.endNode);
+    for (const auto& [uuid, count] : valueCounts)
+    {
+        NodeRef node = graph.manager.GetNode(uuid).lock();
+        for (uint32_t i = 0; i < node->p_outputs.size(); i++)
+        {
+            const std::string declaration = " " + GetOutputVariableName(node, i) + " = ";
+            const size_t first = content.find(declaration);
+            assert(first != std::string::npos && content.find(declaration, first + 1) == std::string::npos);
+        }
+    }
+
+    // An exported shader reads the time from a plain uniform, nothing outside the editor binds the globals block
+    std::string exportedContent;
+    ShaderMaker().CreateFragmentShader(exportedContent, &graph.manager, graph.endNode, true);
+    assert(content.find("uniform " + std::string(c_globalsBlockName)) != std::string::npos);
+    assert(exportedContent.find("uniform float Time;") != std::string::npos && exportedContent.find(c_globalsBlockName) == std::string::npos);
+}
+
+void ShaderMaker::TestSnippetCache()
+{
+    ShaderTestGraph graph;
+    NodeRef firstNode = BuildLattice(graph);
+
+    // Compiling again reuses every snippet, a value edit only emits the edited node
+    ShaderMaker shaderMaker;
+    std::string content;
+    shaderMaker.CreateFragmentShader(content, &graph.manager, graph.endNode);
+    shaderMaker.m_emittedSnippetCount = 0;
+    shaderMaker.CreateFragmentShader(content, &graph.manager, graph.endNode);
+    assert(shaderMaker.m_emittedSnippetCount == 0);
+    firstNode->GetInput(0)->SetValue(Vec3f(1.f, 2.f, 3.f));
+    shaderMaker.CreateFragmentShader(content, &graph.manager, graph.endNode);
+    assert(shaderMaker.m_emittedSnippetCount == 1);
+    std::string fullContent;
+    ShaderMaker().CreateFragmentShader(fullContent, &graph.manager, graph.endNode);
+    assert(content == fullContent);
+}
+
+void ShaderMaker::TestGraphPreview()
+{
+    ShaderTestGraph graph;
+    BuildLattice(graph);
+
+    // A preview assembled from the IR of the whole graph matches the shader built for its node alone
+    NodeRef middleNode = graph.manager.GetNodeConnectedTo(graph.endNode->p_uuid)[c_latticeDepth / 2].lock();
+    ShaderMaker shaderMaker;
+    std::string nodeContent;
+    shaderMaker.CreateFragmentShader(nodeContent, &graph.manager, middleNode);
+    shaderMaker.BuildGraphIR(&graph.manager);
+    shaderMaker.m_emittedSnippetCount = 0;
+    std::string content;
+    shaderMaker.AssembleFragmentShader(content, middleNode->p_uuid);
+    assert(content == nodeContent && shaderMaker.m_emittedSnippetCount == 0);
 }
 
-void ShaderMaker::SerializeFunctions(NodeManager* manager, const NodeRef& node, std::string& content)
+void ShaderMaker::TestUniformInputs()
 {
-    auto templateList = NodeTemplateHandler::GetInstance()->GetTemplates();
-    for (int i = 0; i < node->p_inputs.size(); i++)
+    ShaderTestGraph graph;
+    NodeRef firstNode = BuildLattice(graph);
+
+    // With uniform inputs a value edit gives the same shader, only the uniform value changes
+    ShaderMaker uniformMaker;
+    uniformMaker.SetUniformInputs(true);
+    std::string content;
+    std::vector<ShaderUniform> uniforms;
+    uniformMaker.BuildGraphIR(&graph.manager);
+    uniformMaker.AssembleFragmentShader(content, graph.endNode->p_uuid, &uniforms);
+    firstNode->GetInput(0)->SetValue(Vec3f(4.f, 5.f, 6.f));
+    std::string editedContent;
+    uniformMaker.BuildGraphIR(&graph.manager);
+    uniformMaker.AssembleFragmentShader(editedContent, graph.endNode->p_uuid);
+    assert(content == editedContent && content.find("    vec3 " + GetInputUniformName(firstNode, 0) + ";\n") != std::string::npos);
+    assert(std::ranges::any_of(uniforms, [&](const ShaderUniform& uniform) { return uniform.input.lock() == firstNode->GetInput(0); }));
+}
+
+void ShaderMaker::TestCommonSubexpressions()
+{
+    ShaderTestGraph graph;
+    BuildLattice(graph);
+
+    // With identical sources each layer collapses to a single node
+    for (const NodeRef& node : graph.manager.GetNodes())
     {
-        LinkRef link = manager->GetLinkManager()->GetLinkLinkedToInput(node->GetUUID(), i).lock();
-        if (link == nullptr)
-            continue;
-        NodeRef currentNode = manager->GetNode(link->fromNodeIndex).lock();
-        if (currentNode == nullptr)
-            continue;
-        
-        SerializeFunctions(manager, currentNode, content);
+        if (node && !node->GetInputs().empty() && !node->GetInput(0)->isLinked)
+            node->GetInput(0)->SetValue(Vec3f(1.f, 2.f, 3.f));
+    }
+    ShaderIR ir;
+    ir.Build(&graph.manager, graph.endNode);
+    ir.EliminateCommonSubexpressions();
+    uint32_t computedValueCount = 0;
+    for (const IRValue& value : ir.values)
+    {
+        computedValueCount += value.op != IROp::Constant;
+    }
+    assert(computedValueCount == c_latticeDepth + 2 && ir.GetResult(graph.endNode->p_uuid) == ir.nodes.at(graph.endNode->p_uuid).inputs[0]);
+
+    // With uniform inputs two inputs with the same value stay apart, what reads the same uniforms is still merged
+    ShaderTestGraph uniformGraph;
+    NodeRef texCoords = uniformGraph.AddNode("TexCoords");
+    NodeRef toVector3 = uniformGraph.AddNode("To Vector3 (Vector2)");
+    NodeRef sources[2] = { uniformGraph.AddNode("Add (Vector3)"), uniformGraph.AddNode("Add (Vector3)") };
+    NodeRef sums[2] = { uniformGraph.AddNode("Add (Vector3)"), uniformGraph.AddNode("Add (Vector3)") };
+    NodeRef result = uniformGraph.AddNode("Add (Vector3)");
+    uniformGraph.Link(texCoords, 0, toVector3, 0);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        sources[i]->GetInput(0)->SetValue(Vec3f(1.f, 2.f, 3.f));
+        uniformGraph.Link(toVector3, 0, sources[i], 1);
+        uniformGraph.Link(sources[0], 0, sums[i], 0);
+        uniformGraph.Link(sources[1], 0, sums[i], 1);
+        uniformGraph.Link(sums[i], 0, result, i);
+    }
+    uniformGraph.Link(result, 0, uniformGraph.endNode, 0);
+    ShaderIR uniformIR;
+    uniformIR.uniformInputs = true;
+    uniformIR.Build(&uniformGraph.manager, uniformGraph.endNode);
+    uniformIR.EliminateCommonSubexpressions();
+    assert(uniformIR.GetResult(sources[0]->p_uuid) != uniformIR.GetResult(sources[1]->p_uuid));
+    assert(uniformIR.GetResult(sums[0]->p_uuid) == uniformIR.GetResult(sums[1]->p_uuid));
+}
 
-        FuncStruct& funcStruct = m_functions[currentNode->p_uuid];
-        
-        content += currentNode->ToShader(this, funcStruct);        
+void ShaderMaker::TestConstantFolding()
+{
+    // Constants are folded up to the first value reading the coordinates
+    ShaderTestGraph graph;
+    NodeRef add = graph.AddNode("Add (Float)");
+    NodeRef makeVector3 = graph.AddNode("Make Vector3");
+    NodeRef texCoords = graph.AddNode("TexCoords");
+    NodeRef breakVector2 = graph.AddNode("Break Vector2");
+    add->GetInput(0)->SetValue(2.f);
+    add->GetInput(1)->SetValue(3.f);
+    graph.Link(add, 0, makeVector3, 0);
+    graph.Link(texCoords, 0, breakVector2, 0);
+    graph.Link(breakVector2, 1, makeVector3, 1);
+    graph.Link(makeVector3, 0, graph.endNode, 0);
+
+    ShaderMaker shaderMaker;
+    shaderMaker.BuildIR(&graph.manager, graph.endNode);
+    const ShaderIR& ir = shaderMaker.m_ir;
+    const IRValueID result = ir.GetResult(graph.endNode->p_uuid);
+    const IRValue& folded = ir.values[ir.values[result].operands[0]];
+    assert(!ir.IsConstant(result) && folded.op == IROp::Constant && folded.constant[0] == 5.f);
+
+    // Only the read output of the break node is kept
+    for (const IRValue& value : ir.values)
+    {
+        assert(value.node != breakVector2->p_uuid || value.output == 1);
     }
+
+    // A result far below 1e-6 is written with all its digits, not as 0.000000
+    add->GetInput(0)->SetValue(3e-4f);
+    add->GetInput(1)->SetValue(0.f);
+    NodeRef multiply = graph.AddNode("Multiply (Float)");
+    multiply->GetInput(1)->SetValue(1e-4f);
+    graph.manager.GetLinkManager()->RemoveLink(add, 0, makeVector3, 0);
+    graph.Link(add, 0, multiply, 0);
+    graph.Link(multiply, 0, makeVector3, 0);
+    std::string content;
+    shaderMaker.CreateFragmentShader(content, &graph.manager, graph.endNode);
+    const float smallValue = 3e-4f * 1e-4f;
+    const std::string literal = GetFloatAsString(smallValue);
+    assert(smallValue < 1e-6f && std::stof(literal) == smallValue && content.find(literal) != std::string::npos);
+    assert(GetFloatAsString(1.f) == "1.0" && GetFloatAsString(-2.f) == "-2.0" && std::stof(GetFloatAsString(0.1f)) == 0.1f);
+
+    // With uniform inputs nothing reading an unlinked input is folded, a value edit gives the same shader
+    ShaderMaker uniformMaker;
+    uniformMaker.SetUniformInputs(true);
+    uniformMaker.BuildIR(&graph.manager, graph.endNode);
+    const ShaderIR& uniformIR = uniformMaker.m_ir;
+    assert(!uniformIR.IsConstant(uniformIR.values[uniformIR.GetResult(graph.endNode->p_uuid)].operands[0]));
+    std::string uniformContent;
+    uniformMaker.CreateFragmentShader(uniformContent, &graph.manager, graph.endNode);
+    add->GetInput(0)->SetValue(2.f);
+    std::string editedContent;
+    uniformMaker.CreateFragmentShader(editedContent, &graph.manager, graph.endNode);
+    assert(uniformContent == editedContent && uniformContent.find(literal) == std::string::npos);
+}
+
+void ShaderMaker::TestSimplification()
+{
+    // pow(x, 2) / 4 saturated twice becomes one saturate of x * x * 0.25
+    ShaderTestGraph graph;
+    NodeRef power = graph.AddNode("Power (Float)");
+    NodeRef divide = graph.AddNode("Divide (Float)");
+    std::vector<NodeRef> chain = { graph.AddNode("TexCoords"), graph.AddNode("Break Vector2"), power, divide, graph.AddNode("Saturate (Float)"), graph.AddNode("Saturate (Float)"), graph.AddNode("Make Vector3"), graph.endNode };
+    for (size_t i = 0; i + 1 < chain.size(); i++)
+    {
+        graph.Link(chain[i], 0, chain[i + 1], 0);
+    }
+    power->GetInput(1)->SetValue(2.f);
+    divide->GetInput(1)->SetValue(4.f);
+
+    ShaderSimplifier::ResetHitCounts();
+    std::string content;
+    ShaderMaker().CreateFragmentShader(content, &graph.manager, graph.endNode);
+    assert(ShaderSimplifier::GetHitCount(SimplifyRule::PowerToMultiply) == 1);
+    assert(ShaderSimplifier::GetHitCount(SimplifyRule::DivideByConstant) == 1);
+    assert(ShaderSimplifier::GetHitCount(SimplifyRule::SaturateSaturate) == 1);
+    assert(content.find("pow(") == std::string::npos && content.find(" / ") == std::string::npos);
+    // The two saturates read the same value once the inner one is skipped, only one is left
+    const size_t clamp = content.find("clamp(");
+    assert(clamp != std::string::npos && content.find("clamp(", clamp + 1) == std::string::npos);
+
+    // With uniform inputs the exponent and the divisor are not known, only the structural rules apply
+    ShaderSimplifier::ResetHitCounts();
+    ShaderMaker uniformMaker;
+    uniformMaker.SetUniformInputs(true);
+    uniformMaker.CreateFragmentShader(content, &graph.manager, graph.endNode);
+    assert(ShaderSimplifier::GetHitCount(SimplifyRule::PowerToMultiply) == 0);
+    assert(ShaderSimplifier::GetHitCount(SimplifyRule::DivideByConstant) == 0);
+    assert(ShaderSimplifier::GetHitCount(SimplifyRule::SaturateSaturate) == 1);
+    assert(content.find("pow(") != std::string::npos && content.find(" / ") != std::string::npos);
+
+    // The reciprocal of a large divisor keeps its digits, one too large to be a normal float keeps the division
+    ShaderTestGraph divideGraph;
+    NodeRef largeDivide = divideGraph.AddNode("Divide (Float)");
+    NodeRef makeVector3 = divideGraph.AddNode("Make Vector3");
+    chain = { divideGraph.AddNode("TexCoords"), divideGraph.AddNode("Break Vector2"), largeDivide, makeVector3, divideGraph.endNode };
+    for (size_t i = 0; i + 1 < chain.size(); i++)
+    {
+        divideGraph.Link(chain[i], 0, chain[i + 1], 0);
+    }
+    largeDivide->GetInput(1)->SetValue(3e6f);
+    ShaderMaker().CreateFragmentShader(content, &divideGraph.manager, divideGraph.endNode);
+    assert(content.find(" * " + GetFloatAsString(1.f / 3e6f) + ";") != std::string::npos && content.find(" / ") == std::string::npos);
+    largeDivide->GetInput(1)->SetValue(3e38f);
+    ShaderMaker().CreateFragmentShader(content, &divideGraph.manager, divideGraph.endNode);
+    assert(content.find(" / " + GetFloatAsString(3e38f) + ";") != std::string::npos);
+}
+
+void ShaderMaker::TestShaderFormat()
+{
+    // Extra arguments are ignored
+    std::string formatted;
+    ShaderFormat("%s + %s").Append(formatted, { "a", "b", "c" });
+    assert(formatted == "a + b");
 }
 
 std::string ShaderMaker::GetValueAsString(InputRef input)
 {
-    switch (input->type)
+    return GetValueAsString(input->type, input->GetValue());
+}
+
+std::string ShaderMaker::GetFloatAsString(float value)
+{
+    // Shortest text that reads back as the same float, folded values can be far below the 6 decimals of %f
+    char buffer[32];
+    char* end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    std::string result(buffer, end);
+    // "1" would be an int for GLSL
+    if (result.find_first_of(".en") == std::string::npos)
+        result += ".0";
+    return result;
+}
+
+std::string ShaderMaker::GetValueAsString(Type type, const Vec4f& value)
+{
+    switch (type)
     {
     case Type::Float:
-        return std::to_string(input->GetValue<float>());
+        return GetFloatAsString(value.x);
     case Type::Int:
-        return std::to_string(input->GetValue<int>());
+        return std::to_string(static_cast<int>(value.x));
     case Type::Bool:
-        return std::to_string(input->GetValue<bool>());
+        return std::to_string(static_cast<bool>(value.x));
     case Type::Vector2:
-        {
-            Vec2f value = input->GetValue<Vec2f>();
-            return "vec2(" + std::to_string(value.x) + ", " + std::to_string(value.y) + ")";
-        }
+        return "vec2(" + GetFloatAsString(value.x) + ", " + GetFloatAsString(value.y) + ")";
     case Type::Vector3:
-        {
-            Vec3f value = input->GetValue<Vec3f>();
-            return "vec3(" + std::to_string(value.x) + ", " + std::to_string(value.y) + ", " + std::to_string(value.z) + ")";
-        }
+        return "vec3(" + GetFloatAsString(value.x) + ", " + GetFloatAsString(value.y) + ", " + GetFloatAsString(value.z) + ")";
+    case Type::Vector4:
+        return "vec4(" + GetFloatAsString(value.x) + ", " + GetFloatAsString(value.y) + ", " + GetFloatAsString(value.z) + ", " + GetFloatAsString(value.w) + ")";
     default:
         return "";
     }
@@ -333,6 +757,13 @@ std::string ShaderMaker::GetOutputVariableName(NodeRef currentNode, int j)
     return name + "_" + std::to_string(currentNode->p_uuid) + "_" + std::to_string(j);
 }
 
+std::string ShaderMaker::GetInputUniformName(const NodeRef& node, uint32_t index)
+{
+    auto name = node->GetName();
+    CleanString(name);
+    return name + "_" + std::to_string(node->GetUUID()) + "_in" + std::to_string(index);
+}
+
 std::string ShaderMaker::TypeToGLSLType(Type type)
 {
     switch (type)
@@ -0,0 +1,262 @@
+#include "NodeSystem/ShaderSimplifier.h"
+
+#include <cmath>
+#include <unordered_map>
+
+#include "NodeSystem/NodeTemplateHandler.h"
+#include "NodeSystem/ShaderEvaluator.h"
+
+std::array<std::atomic<uint64_t>, static_cast<size_t>(SimplifyRule::Count)> ShaderSimplifier::s_hitCounts = {};
+
+enum class TemplateKind : uint8_t
+{
+    None,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Power,
+    Saturate,
+    OneMinus,
+};
+
+// Kind of every type variant of the templates with rules, the type suffix of duplicated names is ignored
+static const std::unordered_map<TemplateID, TemplateKind>& GetTemplateKinds()
+{
+    static const std::unordered_map<TemplateID, TemplateKind> kinds = []
+    {
+        const std::unordered_map<std::string, TemplateKind> kindNames =
+        {
+            { "Add", TemplateKind::Add },
+            { "Subtract", TemplateKind::Subtract },
+            { "Multiply", TemplateKind::Multiply },
+            { "Multiply scalar", TemplateKind::Multiply },
+            { "Divide", TemplateKind::Divide },
+            { "Power", TemplateKind::Power },
+            { "Saturate", TemplateKind::Saturate },
+            { "One Minus", TemplateKind::OneMinus },
+        };
+
+        std::unordered_map<TemplateID, TemplateKind> result;
+        for (const NodeMethodInfo& info : NodeTemplateHandler::GetInstance()->GetTemplates())
+        {
+            std::string name = info.node->GetName();
+            if (const size_t suffix = name.rfind(" ("); suffix != std::string::npos && name.back() == ')')
+                name.erase(suffix);
+            if (auto it = kindNames.find(name); it != kindNames.end())
+                result[info.node->GetTemplateID()] = it->second;
+        }
+        return result;
+    }();
+    return kinds;
+}
+
+// "%s * %s ..." with the given number of factors, from 2 to 4
+static const ShaderFormatRef& GetMultiplyFormat(uint32_t factorCount)
+{
+    static const ShaderFormatRef formats[] =
+    {
+        std::make_shared<const ShaderFormat>("%s * %s"),
+        std::make_shared<const ShaderFormat>("%s * %s * %s"),
+        std::make_shared<const ShaderFormat>("%s * %s * %s * %s"),
+    };
+    return formats[factorCount - 2];
+}
+
+static TemplateKind GetTemplateKind(const IRValue& value)
+{
+    if (value.op != IROp::Template)
+        return TemplateKind::None;
+    auto it = GetTemplateKinds().find(value.templateID);
+    return it == GetTemplateKinds().end() ? TemplateKind::None : it->second;
+}
+
+// True if every used component of the value is the given constant
+static bool IsConstantEqual(const IRValue& value, float constant)
+{
+    if (value.op != IROp::Constant)
+        return false;
+    for (uint32_t i = 0; i < ShaderEvaluator::GetComponentCount(value.type); i++)
+    {
+        if (value.constant[i] != constant)
+            return false;
+    }
+    return true;
+}
+
+void ShaderSimplifier::Simplify(ShaderIR& ir)
+{
+    // The IR is rebuilt in order, a rule may forward a value to one of its operands or add a constant before it
+    std::vector<IRValue> values;
+    values.reserve(ir.values.size());
+    std::vector<IRValueID> newIDs(ir.values.size(), c_invalidIRValue);
+
+    for (IRValueID id = 0; id < ir.values.size(); id++)
+    {
+        IRValue value = std::move(ir.values[id]);
+        for (IRValueID& operand : value.operands)
+        {
+            operand = newIDs[operand];
+        }
+
+        // Apply the rules until none matches, a rewrite can enable another rule
+        IRValueID forward = c_invalidIRValue;
+        TemplateKind kind = GetTemplateKind(value);
+        while (kind != TemplateKind::None && forward == c_invalidIRValue)
+        {
+            const TemplateKind previousKind = kind;
+            const std::vector<IRValueID>& operands = value.operands;
+            auto sameType = [&](IRValueID operand) { return values[operand].type == value.type; };
+            switch (kind)
+            {
+            case TemplateKind::Add:
+                if (operands.size() == 2 && IsConstantEqual(values[operands[1]], 0.f) && sameType(operands[0]))
+                    forward = operands[0];
+                else if (operands.size() == 2 && IsConstantEqual(values[operands[0]], 0.f) && sameType(operands[1]))
+                    forward = operands[1];
+                if (forward != c_invalidIRValue)
+                    AddHit(SimplifyRule::AddZero);
+                break;
+            case TemplateKind::Subtract:
+                if (operands.size() == 2 && IsConstantEqual(values[operands[1]], 0.f) && sameType(operands[0]))
+                {
+                    forward = operands[0];
+                    AddHit(SimplifyRule::SubtractZero);
+                }
+                break;
+            case TemplateKind::Multiply:
+                if (operands.size() == 2 && IsConstantEqual(values[operands[1]], 1.f) && sameType(operands[0]))
+                    forward = operands[0];
+                else if (operands.size() == 2 && IsConstantEqual(values[operands[0]], 1.f) && sameType(operands[1]))
+                    forward = operands[1];
+                if (forward != c_invalidIRValue)
+                    AddHit(SimplifyRule::MultiplyOne);
+                break;
+            case TemplateKind::Divide:
+                {
+                    if (operands.size() != 2 || values[operands[1]].op != IROp::Constant)
+                        break;
+                    // A denormal reciprocal can be flushed to zero by the GPU, the division is kept.
+                    // Literals are written in round-trip form so a normal reciprocal is emitted exactly
+                    IRValue reciprocal = values[operands[1]];
+                    bool normal = true;
+                    for (uint32_t i = 0; i < ShaderEvaluator::GetComponentCount(reciprocal.type); i++)
+                    {
+                        reciprocal.constant[i] = 1.f / reciprocal.constant[i];
+                        normal &= std::isnormal(reciprocal.constant[i]);
+                    }
+                    if (!normal)
+                        break;
+                    reciprocal.node = UUID_NULL;
+                    value.operands[1] = static_cast<IRValueID>(values.size());
+                    values.push_back(std::move(reciprocal));
+                    value.format = GetMultiplyFormat(2);
+                    kind = TemplateKind::Multiply;
+                    AddHit(SimplifyRule::DivideByConstant);
+                    break;
+                }
+            case TemplateKind::Power:
+                {
+                    if (operands.size() != 2 || values[operands[1]].op != IROp::Constant)
+                        break;
+                    const float exponent = values[operands[1]].constant[0];
+                    if (!IsConstantEqual(values[operands[1]], exponent) || exponent != std::floor(exponent) || exponent < 1.f || exponent > 4.f)
+                        break;
+                    if (exponent == 1.f)
+                    {
+                        forward = operands[0];
+                        AddHit(SimplifyRule::PowerOne);
+                        break;
+                    }
+                    // The base is a variable or a literal, repeating it costs nothing
+                    value.format = GetMultiplyFormat(static_cast<uint32_t>(exponent));
+                    const IRValueID base = operands[0];
+                    value.operands.assign(static_cast<size_t>(exponent), base);
+                    kind = TemplateKind::None;
+                    AddHit(SimplifyRule::PowerToMultiply);
+                    break;
+                }
+            case TemplateKind::Saturate:
+                if (!operands.empty() && GetTemplateKind(values[operands[0]]) == TemplateKind::Saturate)
+                {
+                    // The inner saturate is removed later if nothing else reads it
+                    value.operands[0] = values[operands[0]].operands[0];
+                    AddHit(SimplifyRule::SaturateSaturate);
+                    continue;
+                }
+                break;
+            case TemplateKind::OneMinus:
+                if (!operands.empty() && GetTemplateKind(values[operands[0]]) == TemplateKind::OneMinus && sameType(values[operands[0]].operands[0]))
+                {
+                    forward = values[operands[0]].operands[0];
+                    AddHit(SimplifyRule::OneMinusOneMinus);
+                }
+                break;
+            default:
+                break;
+            }
+            if (kind == previousKind)
+                break;
+        }
+
+        if (forward != c_invalidIRValue)
+        {
+            newIDs[id] = forward;
+            continue;
+        }
+        newIDs[id] = static_cast<IRValueID>(values.size());
+        values.push_back(std::move(value));
+    }
+
+    for (auto& [uuid, node] : ir.nodes)
+    {
+        for (IRValueID& input : node.inputs)
+        {
+            input = newIDs[input];
+        }
+        for (IRValueID& output : node.outputs)
+        {
+            if (output != c_invalidIRValue)
+                output = newIDs[output];
+        }
+    }
+    ir.values = std::move(values);
+}
+
+const char* ShaderSimplifier::GetRuleName(SimplifyRule rule)
+{
+    switch (rule)
+    {
+    case SimplifyRule::AddZero:
+        return "Add zero";
+    case SimplifyRule::SubtractZero:
+        return "Subtract zero";
+    case SimplifyRule::MultiplyOne:
+        return "Multiply by one";
+    case SimplifyRule::DivideByConstant:
+        return "Divide by constant";
+    case SimplifyRule::PowerOne:
+        return "Power of one";
+    case SimplifyRule::PowerToMultiply:
+        return "Power to multiply";
+    case SimplifyRule::SaturateSaturate:
+        return "Saturate of saturate";
+    case SimplifyRule::OneMinusOneMinus:
+        return "One minus of one minus";
+    default:
+        return "";
+    }
+}
+
+void ShaderSimplifier::AddHit(SimplifyRule rule)
+{
+    s_hitCounts[static_cast<size_t>(rule)]++;
+}
+
+void ShaderSimplifier::ResetHitCounts()
+{
+    for (std::atomic<uint64_t>& hitCount : s_hitCounts)
+    {
+        hitCount = 0;
+    }
+}
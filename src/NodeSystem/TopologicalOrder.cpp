@@ -0,0 +1,190 @@
+#include "NodeSystem/TopologicalOrder.h"
+
+#include <algorithm>
+
+bool TopologicalOrder::AddEdge(const UUID& from, const UUID& to)
+{
+    if (from == to)
+        return false;
+
+    Entry& fromEntry = GetOrCreateEntry(from);
+    Entry& toEntry = GetOrCreateEntry(to);
+
+    const uint32_t lowerBound = toEntry.position;
+    const uint32_t upperBound = fromEntry.position;
+    if (lowerBound < upperBound)
+    {
+        // The nodes between both ends have to be reordered
+        std::vector<UUID> forward;
+        if (!SearchForward(to, upperBound, from, forward))
+            return false;
+        std::vector<UUID> backward;
+        SearchBackward(from, lowerBound + 1, backward);
+
+        auto byPosition = [this](const UUID& a, const UUID& b) { return m_entries.at(a).position < m_entries.at(b).position; };
+        std::ranges::sort(forward, byPosition);
+        std::ranges::sort(backward, byPosition);
+
+        // Reuse the positions of both sets, the nodes reaching 'from' go before the nodes reached from 'to'
+        std::vector<uint32_t> positions;
+        positions.reserve(forward.size() + backward.size());
+        for (const UUID& node : backward)
+        {
+            positions.push_back(m_entries.at(node).position);
+        }
+        for (const UUID& node : forward)
+        {
+            positions.push_back(m_entries.at(node).position);
+        }
+        std::ranges::sort(positions);
+
+        uint32_t i = 0;
+        for (const std::vector<UUID>* nodes : { &backward, &forward })
+        {
+            for (const UUID& node : *nodes)
+            {
+                m_entries.at(node).position = positions[i];
+                m_positionToNode[positions[i]] = node;
+                i++;
+            }
+        }
+    }
+
+    fromEntry.successors.push_back(to);
+    toEntry.predecessors.push_back(from);
+    return true;
+}
+
+void TopologicalOrder::RemoveEdge(const UUID& from, const UUID& to)
+{
+    auto fromIt = m_entries.find(from);
+    auto toIt = m_entries.find(to);
+    if (fromIt == m_entries.end() || toIt == m_entries.end())
+        return;
+
+    std::vector<UUID>& successors = fromIt->second.successors;
+    if (auto it = std::ranges::find(successors, to); it != successors.end())
+        successors.erase(it);
+    std::vector<UUID>& predecessors = toIt->second.predecessors;
+    if (auto it = std::ranges::find(predecessors, from); it != predecessors.end())
+        predecessors.erase(it);
+}
+
+void TopologicalOrder::RemoveNode(const UUID& node)
+{
+    auto it = m_entries.find(node);
+    if (it == m_entries.end())
+        return;
+
+    for (const UUID& successor : it->second.successors)
+    {
+        std::erase(m_entries.at(successor).predecessors, node);
+    }
+    for (const UUID& predecessor : it->second.predecessors)
+    {
+        std::erase(m_entries.at(predecessor).successors, node);
+    }
+
+    m_positionToNode[it->second.position] = UUID_NULL;
+    m_entries.erase(it);
+    m_holeCount++;
+
+    if (m_holeCount > m_positionToNode.size() / 2)
+        Compact();
+}
+
+void TopologicalOrder::Clear()
+{
+    m_entries.clear();
+    m_positionToNode.clear();
+    m_holeCount = 0;
+}
+
+bool TopologicalOrder::WouldCreateCycle(const UUID& from, const UUID& to) const
+{
+    if (from == to)
+        return true;
+    auto fromIt = m_entries.find(from);
+    auto toIt = m_entries.find(to);
+    if (fromIt == m_entries.end() || toIt == m_entries.end())
+        return false;
+    // Already in order, no path can go back from 'to' to 'from'
+    if (toIt->second.position > fromIt->second.position)
+        return false;
+
+    std::vector<UUID> visited;
+    return !SearchForward(to, fromIt->second.position, from, visited);
+}
+
+void TopologicalOrder::GetUpstream(const UUID& node, std::vector<UUID>& result) const
+{
+    result.clear();
+    if (!Contains(node))
+    {
+        // Not linked to anything
+        result.push_back(node);
+        return;
+    }
+
+    SearchBackward(node, 0, result);
+    std::ranges::sort(result, [this](const UUID& a, const UUID& b) { return m_entries.at(a).position < m_entries.at(b).position; });
+}
+
+TopologicalOrder::Entry& TopologicalOrder::GetOrCreateEntry(const UUID& node)
+{
+    auto [it, inserted] = m_entries.try_emplace(node);
+    if (inserted)
+    {
+        it->second.position = static_cast<uint32_t>(m_positionToNode.size());
+        m_positionToNode.push_back(node);
+    }
+    return it->second;
+}
+
+bool TopologicalOrder::SearchForward(const UUID& start, uint32_t upperBound, const UUID& target, std::vector<UUID>& visited) const
+{
+    // Iterative so deep graphs cannot overflow the stack
+    std::unordered_set<UUID> seen = { start };
+    std::vector<UUID> stack = { start };
+    while (!stack.empty())
+    {
+        UUID node = stack.back();
+        stack.pop_back();
+        visited.push_back(node);
+        for (const UUID& successor : m_entries.at(node).successors)
+        {
+            if (successor == target)
+                return false;
+            if (m_entries.at(successor).position < upperBound && seen.insert(successor).second)
+                stack.push_back(successor);
+        }
+    }
+    return true;
+}
+
+void TopologicalOrder::SearchBackward(const UUID& start, uint32_t lowerBound, std::vector<UUID>& visited) const
+{
+    std::unordered_set<UUID> seen = { start };
+    std::vector<UUID> stack = { start };
+    while (!stack.empty())
+    {
+        UUID node = stack.back();
+        stack.pop_back();
+        visited.push_back(node);
+        for (const UUID& predecessor : m_entries.at(node).predecessors)
+        {
+            if (m_entries.at(predecessor).position >= lowerBound && seen.insert(predecessor).second)
+                stack.push_back(predecessor);
+        }
+    }
+}
+
+void TopologicalOrder::Compact()
+{
+    std::erase(m_positionToNode, UUID(UUID_NULL));
+    for (uint32_t i = 0; i < m_positionToNode.size(); i++)
+    {
+        m_entries.at(m_positionToNode[i]).position = i;
+    }
+    m_holeCount = 0;
+}
@@ -17,11 +17,15 @@
 #include "NodeSystem/CustomNode.h"
 #include "NodeSystem/ParamNode.h"
 #include "NodeSystem/ShaderMaker.h"
+#include "NodeSystem/ShaderSimplifier.h"
 
 #include "Application.h"
 #include "Serializer.h"
 
 #include "Render/Framebuffer.h"
+#include "Render/ParameterBuffer.h"
+#include "Render/ProgramBinaryCache.h"
+#include "Render/ProgramCache.h"
 
 #include "Actions/ActionCreateNode.h"
 #include "Actions/ActionPaste.h"
@@ -103,6 +107,8 @@ std::string OpenDialog(const std::vector<Filter>& filters, const char* defaultPa
 void NodeWindow::Initialize()
 {
     m_actionManager.SetContext(this);
+    // Editing is the common case, the optimizations on literals can be had back from the Options menu
+    m_shaderMaker.SetUniformInputs(true);
     auto templateHandler = NodeTemplateHandler::Create();
 
     templateHandler->Initialize();
@@ -244,31 +250,42 @@ void NodeWindow::Draw()
 
 void NodeWindow::Render()
 {
-    // UpdateShader();
     UpdateShaders();
 
+    // The values of every shader are written first and sent with one upload before the draws
+    ParameterBuffer& parameters = ParameterBuffer::GetInstance();
+    parameters.BeginFrame(Application::GetInstance()->GetTime());
+    std::vector<Node*> previewNodes;
     for (auto it = m_previewNodes.begin(); it != m_previewNodes.end();)
     {
-        const auto previewNode = m_nodeManager->GetNode(*it).lock();
+        Node* previewNode = m_nodeManager->FindNode(*it);
 
         if (!previewNode || !previewNode->p_preview)
         {
             it = m_previewNodes.erase(it); // Erase returns the next valid iterator
             continue;
         }
+        previewNode->m_shader->UpdateCompilation();
+        previewNode->m_shader->UpdateValues();
+        previewNodes.push_back(previewNode);
+        ++it;
+    }
+    m_currentShader->UpdateCompilation();
+    m_currentShader->UpdateValues();
+    parameters.Upload();
+
+    for (Node* previewNode : previewNodes)
+    {
         previewNode->m_framebuffer->Update();
         previewNode->m_framebuffer->Bind();
         previewNode->m_shader->Use();
-        previewNode->m_shader->UpdateValues();
         m_quad->Draw();
         previewNode->m_framebuffer->Unbind();
-        ++it;
     }
 
     m_framebuffer->Update();
     m_framebuffer->Bind();
     m_currentShader->Use();
-    m_currentShader->UpdateValues();
     m_quad->Draw();
     m_framebuffer->Unbind();
 }
@@ -336,10 +353,35 @@ void NodeWindow::DrawMainBar()
         std::string fpsString = std::to_string(static_cast<int>(ImGui::GetIO().Framerate)) + " FPS";
         if (ImGui::BeginMenu(fpsString.c_str()))
         {
-            
+            // Shader simplifications applied since the start
+            for (uint8_t i = 0; i < static_cast<uint8_t>(SimplifyRule::Count); i++)
+            {
+                const SimplifyRule rule = static_cast<SimplifyRule>(i);
+                ImGui::Text("%s : %llu", ShaderSimplifier::GetRuleName(rule), static_cast<unsigned long long>(ShaderSimplifier::GetHitCount(rule)));
+            }
+            ImGui::Separator();
+            const ProgramCache& programCache = ProgramCache::GetInstance();
+            ImGui::Text("Program cache : %llu hits, %llu misses", static_cast<unsigned long long>(programCache.GetHitCount()), static_cast<unsigned long long>(programCache.GetMissCount()));
+            ImGui::Text("%zu programs, %zu / %zu KB", programCache.GetProgramCount(), programCache.GetMemoryUsage() / 1024, programCache.GetMemoryCap() / 1024);
+            const ProgramBinaryCache& binaryCache = ProgramBinaryCache::GetInstance();
+            ImGui::Text("Program binaries : %llu hits, %llu misses, %zu KB", static_cast<unsigned long long>(binaryCache.GetHitCount()), static_cast<unsigned long long>(binaryCache.GetMissCount()), binaryCache.GetSize() / 1024);
+            ImGui::Text("Parameter buffer : %u bytes", ParameterBuffer::GetInstance().GetSize());
             ImGui::EndMenu();
         }
         
+        if (ImGui::BeginMenu("Options"))
+        {
+            bool uniformInputs = m_shaderMaker.GetUniformInputs();
+            if (ImGui::MenuItem("Live value edits", nullptr, &uniformInputs))
+            {
+                m_shaderMaker.SetUniformInputs(uniformInputs);
+                m_shouldUpdateShader = true;
+            }
+            if (ImGui::IsItemHovered())
+                ImGui::SetTooltip("Unlinked inputs are uniforms, editing a value needs no recompile.\nConstants are no longer folded or simplified, exports are not affected");
+            ImGui::EndMenu();
+        }
+
         std::string stateString = "Current State :" + UserInputEnumToString(m_nodeManager->GetUserInputState());
         if (ImGui::BeginMenu(stateString.c_str()))
         {
@@ -348,6 +390,14 @@ void NodeWindow::DrawMainBar()
 
         if (ImGui::BeginMenu("Debug"))
         {
+#ifdef _DEBUG
+            // Asserts on failure, only run when asked
+            if (ImGui::MenuItem("Run shader tests"))
+            {
+                ShaderMaker::RunUnitTests();
+            }
+            ImGui::Separator();
+#endif
             auto current = ActionManager::GetCurrent();
             if (current != nullptr)
             {
@@ -424,6 +474,11 @@ void NodeWindow::DrawInspector() const
     m_framebuffer->SetNewSize(size);
     ImGui::Dummy(Vec2f(5, 5));
     ImGui::Image(reinterpret_cast<ImTextureID>(m_framebuffer->GetRenderTexture()), size, ImVec2(0, 1), ImVec2(1, 0), ImVec4(1, 1, 1, 1), ImVec4(1, 1, 1, 1));
+    // The image shows the previous program until the new one is linked
+    if (m_currentShader->GetStatus() == ShaderStatus::Failed)
+        ImGui::TextColored(ImVec4(0.86f, 0.2f, 0.2f, 1.f), "Shader error, showing the last valid shader");
+    else if (m_currentShader->GetStatus() != ShaderStatus::Ready)
+        ImGui::Text("Compiling...");
     ImGui::Separator();
 
     if (NodeRef selectedNode = m_nodeManager->GetSelectedNode().lock())
@@ -604,34 +659,19 @@ void NodeWindow::SetOpenContextMenu(bool shouldOpen)
     m_shouldOpenContextMenu = shouldOpen;
 }
 
-void NodeWindow::UpdateShader()
-{
-    if (m_shouldUpdateShader)
-    {
-        ShaderMaker shaderMaker;
-        std::string content;
-        
-        shaderMaker.CreateFragmentShader(content, m_nodeManager);
-        
-        m_currentShader->RecompileFragmentShader(content.c_str());
-        
-        m_shouldUpdateShader = false;
-    }
-}
-
 void NodeWindow::UpdateShaders()
 {
     if (m_shouldUpdateShader)
     {
-        ShaderMaker shaderMaker;
-        
-        shaderMaker.DoWork(m_nodeManager);
+        m_shaderMaker.DoWork(m_nodeManager);
         
+        // The IR of the whole graph is already built, the material is one more preview
         std::string content;
+        std::vector<ShaderUniform> uniforms;
+        if (NodeRef endNode = m_nodeManager->GetNodeWithName("Material").lock())
+            m_shaderMaker.AssembleFragmentShader(content, endNode->GetUUID(), &uniforms);
         
-        shaderMaker.CreateFragmentShader(content, m_nodeManager);
-        
-        m_currentShader->RecompileFragmentShader(content.c_str());
+        m_currentShader->SubmitFragmentShader(content.c_str(), std::move(uniforms));
         
         m_shouldUpdateShader = false;
     }
@@ -1,10 +1,13 @@
 #include "Render/Framebuffer.h"
 
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <glad/glad.h>
 
 #include "Application.h"
+#include "NodeSystem/Node.h"
+#include "Render/ProgramBinaryCache.h"
 
 Ref<Mesh> Mesh::CreateQuad()
 {
@@ -43,6 +46,8 @@ void Mesh::Draw() const
     glBindVertexArray(0);
 }
 
+bool Shader::s_parallelCompilation = false;
+
 static std::string s_defaultVertShader = R"(#version 330 core
 layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec2 aTexCoords;
@@ -57,7 +62,10 @@ void main()
 )"; 
 static std::string s_defaultFragShader = R"(#version 330 core
 in vec2 TexCoords;
-uniform float Time;
+layout(std140) uniform Globals
+{
+    float Time;
+};
 out vec4 FragColor;
 
 void main()
@@ -66,6 +74,20 @@ void main()
 }
 )"; 
 
+Shader::~Shader()
+{
+    if (m_vertexShader != static_cast<uint32_t>(-1))
+        glDeleteShader(m_vertexShader);
+    // Attached to the program, the driver frees it with the program
+    if (m_fragmentShader != static_cast<uint32_t>(-1))
+        glDeleteShader(m_fragmentShader);
+    if (m_pendingFragmentShader != 0)
+        glDeleteShader(m_pendingFragmentShader);
+    // Program created by LoadVertexShader and never linked, a linked one is deleted with m_sharedProgram
+    if (m_sharedProgram == nullptr && m_program != static_cast<uint32_t>(-1))
+        glDeleteProgram(m_program);
+}
+
 bool Shader::LoadDefaultShader()
 {
     return Load(s_defaultVertShader.c_str(), s_defaultFragShader.c_str());
@@ -99,6 +121,7 @@ bool Shader::Load(const std::filesystem::path& path)
 
 bool Shader::Load(const char* vertSource, const char* fragSource)
 {
+    m_vertexHash = std::hash<std::string_view>{}(vertSource);
     m_program = glCreateProgram();
     m_vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(m_vertexShader, 1, &vertSource, nullptr);
@@ -132,7 +155,6 @@ bool Shader::Load(const char* vertSource, const char* fragSource)
     
     Link();
     
-    glDeleteShader(m_vertexShader);
     m_loaded = true;
     return true;
 }
@@ -151,6 +173,7 @@ bool Shader::LoadVertexShader(const std::filesystem::path& vertPath)
 
 bool Shader::LoadVertexShader(const char* vertSource)
 {
+    m_vertexHash = std::hash<std::string_view>{}(vertSource);
     m_program = glCreateProgram();
     m_vertexShader = glCreateShader(GL_VERTEX_SHADER);
     glShaderSource(m_vertexShader, 1, &vertSource, nullptr);
@@ -193,25 +216,41 @@ bool Shader::SetFragmentShaderContent(const std::string& string)
 bool Shader::Link()
 {
     glLinkProgram(m_program);
+    m_loaded = CheckLinkStatus(m_program);
+    if (m_loaded)
+    {
+        // Not in the cache, only this shader uses it
+        m_sharedProgram = std::make_shared<ShaderProgram>(m_program, 0);
+        m_sharedProgram->Reflect();
+    }
+    return m_loaded;
+}
+
+bool Shader::CheckLinkStatus(uint32_t program) const
+{
     int success;
     char infoLog[512];
     // Check for linking errors
-    glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(m_program, 512, nullptr, infoLog);
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
         std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        m_loaded = false;
         return false;
     }
-    m_loaded = true;
     return true;
 }
 
 void Shader::Use() const
 {
-    if (!m_loaded)
+    if (!m_loaded || !m_sharedProgram)
         return;
     glUseProgram(m_program);
+
+    const GLint timeLocation = m_sharedProgram->GetLayout().timeLocation;
+    if (timeLocation != -1)
+        glUniform1f(timeLocation, Application::GetInstance()->GetTime());
+    if (m_parameters.size != 0)
+        ParameterBuffer::GetInstance().BindParameters(m_parameters);
 }
 
 bool Shader::RecompileFragmentShader()
@@ -225,63 +264,195 @@ bool Shader::RecompileFragmentShader()
 
 bool Shader::RecompileFragmentShader(const char* content)
 {
-    // Retrieve the existing fragment shader
-    GLint attachedShaders = 0;
-    GLuint shaders[2]; // Typically, a program has a vertex and fragment shader
-    glGetAttachedShaders(m_program, 2, &attachedShaders, shaders);
-
-    GLuint fragmentShader = 0;
-    for (int i = 0; i < attachedShaders; i++)
+    SubmitFragmentShader(content);
+    while (m_status == ShaderStatus::Compiling || m_status == ShaderStatus::Linking)
     {
-        GLint shaderType;
-        glGetShaderiv(shaders[i], GL_SHADER_TYPE, &shaderType);
-        if (shaderType == GL_FRAGMENT_SHADER)
-        {
-            fragmentShader = shaders[i];
-            break;
-        }
+        AdvanceCompilation(true);
     }
+    return m_status == ShaderStatus::Ready;
+}
+
+void Shader::InitializeParallelCompilation()
+{
+    s_parallelCompilation = GLAD_GL_KHR_parallel_shader_compile;
+    if (s_parallelCompilation)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+}
 
-    if (fragmentShader == 0)
+void Shader::SubmitFragmentShader(const char* content, std::vector<ShaderUniform> uniforms)
+{
+    // A newer source replaces the one being compiled
+    if (m_pendingFragmentShader != 0)
+        glDeleteShader(m_pendingFragmentShader);
+    m_pendingFragmentShader = 0;
+    m_pendingProgram.reset();
+
+    m_pendingContent = content;
+    m_pendingUniforms = std::move(uniforms);
+    const uint64_t key = ProgramCache::GetKey(m_vertexHash, m_pendingContent);
+    if (ShaderProgramRef program = ProgramCache::GetInstance().Find(key, m_vertexHash, m_pendingContent))
     {
-        std::cerr << "No fragment shader found in the program." << std::endl;
+        UseProgram(std::move(program));
+        return;
     }
-    else
+    // A binary saved by a previous session skips the compile
+    if (ShaderProgramRef program = ProgramBinaryCache::GetInstance().CreateProgram(key, m_vertexHash, m_pendingContent))
     {
-        // Delete the old fragment shader
-        glDetachShader(m_program, fragmentShader);
-        glDeleteShader(fragmentShader);
+        UseProgram(ProgramCache::GetInstance().Add(key, m_vertexHash, m_pendingContent, program));
+        return;
     }
-    // Create and compile the new fragment shader
-    GLuint newFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(newFragmentShader, 1, &content, nullptr);
-    glCompileShader(newFragmentShader);
 
-    // Check for compilation errors
-    GLint success;
-    glGetShaderiv(newFragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    m_pendingFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    const char* source = m_pendingContent.c_str();
+    glShaderSource(m_pendingFragmentShader, 1, &source, nullptr);
+    glCompileShader(m_pendingFragmentShader);
+    m_status = ShaderStatus::Compiling;
+}
+
+bool Shader::UpdateCompilation()
+{
+    if (m_status != ShaderStatus::Compiling && m_status != ShaderStatus::Linking)
+        return false;
+    return AdvanceCompilation(false);
+}
+
+bool Shader::AdvanceCompilation(bool wait)
+{
+    if (m_status == ShaderStatus::Compiling)
     {
-        char infoLog[512];
-        glGetShaderInfoLog(newFragmentShader, 512, nullptr, infoLog);
-        std::cerr << "Fragment Shader Compilation Error:\n" << infoLog << std::endl;
+        GLint done = GL_TRUE;
+        if (s_parallelCompilation && !wait)
+            glGetShaderiv(m_pendingFragmentShader, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done)
+            return false;
+
+        const GLuint newFragmentShader = m_pendingFragmentShader;
+        m_pendingFragmentShader = 0;
+
+        // Check for compilation errors
+        GLint success;
+        glGetShaderiv(newFragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            char infoLog[512];
+            glGetShaderInfoLog(newFragmentShader, 512, nullptr, infoLog);
+            std::cerr << "Fragment Shader Compilation Error:\n" << infoLog << std::endl;
+            glDeleteShader(newFragmentShader);
+            ImGui::SetClipboardText(m_pendingContent.c_str());
+            m_status = ShaderStatus::Failed;
+            return false;
+        }
+
+        const GLuint program = glCreateProgram();
+        if (ProgramBinaryCache::GetInstance().IsSupported())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, m_vertexShader);
+        glAttachShader(program, newFragmentShader);
+        glLinkProgram(program);
+        // A linked program no longer needs its shaders
+        glDetachShader(program, m_vertexShader);
+        glDetachShader(program, newFragmentShader);
         glDeleteShader(newFragmentShader);
-        ImGui::SetClipboardText(content);
-        return false;
+
+        // The driver memory of a program is not known, its source length is used as an estimate
+        m_pendingProgram = std::make_shared<ShaderProgram>(program, m_pendingContent.size());
+        m_status = ShaderStatus::Linking;
+
+        // Without the extension the link status is read on the next update, the driver may link meanwhile
+        if (!wait && !s_parallelCompilation)
+            return false;
+    }
+
+    if (m_status == ShaderStatus::Linking)
+    {
+        GLint done = GL_TRUE;
+        if (s_parallelCompilation && !wait)
+            glGetProgramiv(m_pendingProgram->GetID(), GL_COMPLETION_STATUS_KHR, &done);
+        if (!done)
+            return false;
+
+        ShaderProgramRef program = std::move(m_pendingProgram);
+        if (!CheckLinkStatus(program->GetID()))
+        {
+            m_status = ShaderStatus::Failed;
+            return false;
+        }
+        program->Reflect();
+        const uint64_t key = ProgramCache::GetKey(m_vertexHash, m_pendingContent);
+        ProgramBinaryCache::GetInstance().Store(key, m_vertexHash, m_pendingContent, program->GetID());
+        UseProgram(ProgramCache::GetInstance().Add(key, m_vertexHash, m_pendingContent, program));
+        return true;
     }
+    return false;
+}
 
-    // Attach the new shader and relink the program
-    glAttachShader(m_program, newFragmentShader);
-    return Link();
+void Shader::UseProgram(ShaderProgramRef program)
+{
+    // The program created by LoadVertexShader is never linked, nothing else deletes it
+    if (m_sharedProgram == nullptr && m_program != static_cast<uint32_t>(-1))
+        glDeleteProgram(m_program);
+    m_sharedProgram = std::move(program);
+    m_program = m_sharedProgram->GetID();
+    m_uniforms = std::move(m_pendingUniforms);
+    m_parameters = {};
+    // Members optimized out or unknown keep -1 and are not written
+    const ProgramLayout& layout = m_sharedProgram->GetLayout();
+    for (ShaderUniform& uniform : m_uniforms)
+    {
+        auto it = layout.offsets.find(uniform.name);
+        uniform.offset = it != layout.offsets.end() ? static_cast<int32_t>(it->second) : -1;
+    }
+    m_loaded = true;
+    m_status = ShaderStatus::Ready;
 }
 
-void Shader::UpdateValues() const
+void Shader::UpdateValues()
 {
-    // Set time value
-    GLint timeLocation = glGetUniformLocation(m_program, "Time");
-    if (timeLocation != -1) {
-        float time = Application::GetInstance()->GetTime();
-        glUniform1f(timeLocation, time);
+    m_parameters = {};
+    if (!m_loaded || !m_sharedProgram || m_sharedProgram->GetLayout().parametersSize == 0)
+        return;
+
+    // Values of the unlinked inputs, an edit is seen on the next frame without a new shader
+    ParameterBuffer& buffer = ParameterBuffer::GetInstance();
+    m_parameters = buffer.Allocate(m_sharedProgram->GetLayout().parametersSize);
+    char* data = buffer.GetData(m_parameters);
+    for (const ShaderUniform& uniform : m_uniforms)
+    {
+        const Ref<Input> input = uniform.input.lock();
+        if (!input || uniform.offset < 0)
+            continue;
+        const Vec4f& value = input->value;
+        char* member = data + uniform.offset;
+        switch (input->type)
+        {
+        case Type::Float:
+            std::memcpy(member, &value.x, sizeof(float));
+            break;
+        case Type::Int:
+        {
+            const int32_t intValue = static_cast<int32_t>(value.x);
+            std::memcpy(member, &intValue, sizeof(int32_t));
+            break;
+        }
+        case Type::Bool:
+        {
+            // A std140 bool takes 4 bytes
+            const uint32_t boolValue = value.x != 0.f;
+            std::memcpy(member, &boolValue, sizeof(uint32_t));
+            break;
+        }
+        case Type::Vector2:
+            std::memcpy(member, &value.x, 2 * sizeof(float));
+            break;
+        case Type::Vector3:
+            std::memcpy(member, &value.x, 3 * sizeof(float));
+            break;
+        case Type::Vector4:
+            std::memcpy(member, &value.x, 4 * sizeof(float));
+            break;
+        default:
+            break;
+        }
     }
 }
 
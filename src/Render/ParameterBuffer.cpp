@@ -0,0 +1,65 @@
+#include "Render/ParameterBuffer.h"
+
+#include <cstring>
+#include <glad/glad.h>
+
+// std140 size of the globals block, a float padded to a vec4
+constexpr uint32_t c_globalsSize = 16;
+
+ParameterBuffer& ParameterBuffer::GetInstance()
+{
+    static ParameterBuffer buffer;
+    return buffer;
+}
+
+void ParameterBuffer::Initialize()
+{
+    glGenBuffers(1, &m_buffer);
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0)
+        m_offsetAlignment = static_cast<uint32_t>(alignment);
+}
+
+void ParameterBuffer::Destroy()
+{
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+    m_bufferSize = 0;
+}
+
+void ParameterBuffer::BeginFrame(float time)
+{
+    m_data.clear();
+    m_globals = Allocate(c_globalsSize);
+    std::memcpy(GetData(m_globals), &time, sizeof(float));
+}
+
+ParameterRange ParameterBuffer::Allocate(uint32_t size)
+{
+    // glBindBufferRange needs offsets aligned for the driver
+    const uint32_t offset = (GetSize() + m_offsetAlignment - 1) / m_offsetAlignment * m_offsetAlignment;
+    m_data.resize(offset + size);
+    return { offset, size };
+}
+
+void ParameterBuffer::Upload()
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    if (GetSize() > m_bufferSize)
+    {
+        m_bufferSize = GetSize();
+        glBufferData(GL_UNIFORM_BUFFER, m_bufferSize, m_data.data(), GL_DYNAMIC_DRAW);
+    }
+    else
+    {
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, GetSize(), m_data.data());
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferRange(GL_UNIFORM_BUFFER, c_globalsBinding, m_buffer, m_globals.offset, m_globals.size);
+}
+
+void ParameterBuffer::BindParameters(const ParameterRange& range) const
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER, c_parametersBinding, m_buffer, range.offset, range.size);
+}
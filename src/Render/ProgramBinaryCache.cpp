@@ -0,0 +1,236 @@
+#include "Render/ProgramBinaryCache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <glad/glad.h>
+
+// Increase when the layout of the file changes
+constexpr uint32_t c_fileVersion = 1;
+constexpr char c_fileMagic[4] = { 'N', 'E', 'P', 'B' };
+
+template <typename T>
+static void Write(std::ofstream& file, const T& value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool Read(std::ifstream& file, T& value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+ProgramBinaryCache& ProgramBinaryCache::GetInstance()
+{
+    static ProgramBinaryCache cache;
+    return cache;
+}
+
+uint64_t ProgramBinaryCache::GetDeviceHash()
+{
+    std::string device;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        if (const GLubyte* value = glGetString(name))
+            device += reinterpret_cast<const char*>(value);
+        device += '\n';
+    }
+    return std::hash<std::string>{}(device);
+}
+
+void ProgramBinaryCache::Load(const std::filesystem::path& path)
+{
+    m_path = path;
+    GLint formatCount = 0;
+    if (GLAD_GL_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    m_supported = formatCount > 0;
+    if (!m_supported)
+        return;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return;
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t deviceHash = 0;
+    uint32_t entryCount = 0;
+    if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, c_fileMagic) || !Read(file, version) || version != c_fileVersion)
+        return;
+    if (!Read(file, deviceHash) || deviceHash != GetDeviceHash() || !Read(file, entryCount))
+    {
+        // Binaries of another driver are rejected anyway, the file is rewritten on save
+        m_dirty = true;
+        return;
+    }
+
+    // Entries are saved most recently used first
+    for (uint32_t i = 0; i < entryCount; i++)
+    {
+        Entry entry;
+        uint32_t sourceSize = 0;
+        uint32_t binarySize = 0;
+        if (!Read(file, entry.key) || !Read(file, entry.vertexHash) || !Read(file, entry.format) || !Read(file, sourceSize) || !Read(file, binarySize))
+            break;
+        if (static_cast<size_t>(sourceSize) + binarySize > m_sizeLimit)
+            break;
+        entry.fragmentSource.resize(sourceSize);
+        entry.binary.resize(binarySize);
+        if (!file.read(entry.fragmentSource.data(), sourceSize) || !file.read(entry.binary.data(), binarySize))
+            break;
+
+        m_entries.push_back(std::move(entry));
+        m_index.emplace(m_entries.back().key, std::prev(m_entries.end()));
+        m_size += GetEntrySize(m_entries.back());
+    }
+    EvictUntil(m_sizeLimit);
+}
+
+void ProgramBinaryCache::Save() const
+{
+    if (!m_supported || !m_dirty)
+        return;
+
+    // Written next to the file then renamed, a crash never leaves half a file
+    std::filesystem::path tempPath = m_path;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cout << "Failed to save the program binaries to " << m_path << '\n';
+            return;
+        }
+        file.write(c_fileMagic, sizeof(c_fileMagic));
+        Write(file, c_fileVersion);
+        Write(file, GetDeviceHash());
+        Write(file, static_cast<uint32_t>(m_entries.size()));
+        for (const Entry& entry : m_entries)
+        {
+            Write(file, entry.key);
+            Write(file, entry.vertexHash);
+            Write(file, entry.format);
+            Write(file, static_cast<uint32_t>(entry.fragmentSource.size()));
+            Write(file, static_cast<uint32_t>(entry.binary.size()));
+            file.write(entry.fragmentSource.data(), static_cast<std::streamsize>(entry.fragmentSource.size()));
+            file.write(entry.binary.data(), static_cast<std::streamsize>(entry.binary.size()));
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, m_path, error);
+    if (error)
+        std::cout << "Failed to save the program binaries to " << m_path << " : " << error.message() << '\n';
+}
+
+ShaderProgramRef ProgramBinaryCache::CreateProgram(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource)
+{
+    if (!m_supported)
+        return nullptr;
+
+    auto it = Find(key, vertexHash, fragmentSource);
+    if (it == m_entries.end())
+    {
+        m_missCount++;
+        return nullptr;
+    }
+
+    const GLuint program = glCreateProgram();
+    glProgramBinary(program, it->format, it->binary.data(), static_cast<GLsizei>(it->binary.size()));
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // The driver may refuse a binary even with the same version, it is compiled again
+        glDeleteProgram(program);
+        Erase(it);
+        m_missCount++;
+        return nullptr;
+    }
+
+    // The access order is saved too, so the binaries used by a session are not the first evicted
+    if (it != m_entries.begin())
+    {
+        m_entries.splice(m_entries.begin(), m_entries, it);
+        m_dirty = true;
+    }
+    m_hitCount++;
+    ShaderProgramRef shaderProgram = std::make_shared<ShaderProgram>(program, it->binary.size());
+    shaderProgram->Reflect();
+    return shaderProgram;
+}
+
+void ProgramBinaryCache::Store(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource, uint32_t program)
+{
+    if (!m_supported || Find(key, vertexHash, fragmentSource) != m_entries.end())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    Entry entry;
+    entry.key = key;
+    entry.vertexHash = vertexHash;
+    entry.fragmentSource = fragmentSource;
+    entry.binary.resize(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, entry.binary.data());
+    entry.binary.resize(length);
+    entry.format = format;
+    Add(std::move(entry));
+}
+
+void ProgramBinaryCache::SetSizeLimit(size_t sizeLimit)
+{
+    m_sizeLimit = sizeLimit;
+    EvictUntil(m_sizeLimit);
+}
+
+std::list<ProgramBinaryCache::Entry>::iterator ProgramBinaryCache::Find(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource)
+{
+    auto [begin, end] = m_index.equal_range(key);
+    for (auto it = begin; it != end; ++it)
+    {
+        if (it->second->vertexHash == vertexHash && it->second->fragmentSource == fragmentSource)
+            return it->second;
+    }
+    return m_entries.end();
+}
+
+void ProgramBinaryCache::Add(Entry&& entry)
+{
+    if (GetEntrySize(entry) > m_sizeLimit)
+        return;
+    m_entries.push_front(std::move(entry));
+    m_index.emplace(m_entries.front().key, m_entries.begin());
+    m_size += GetEntrySize(m_entries.front());
+    m_dirty = true;
+    EvictUntil(m_sizeLimit);
+}
+
+void ProgramBinaryCache::Erase(std::list<Entry>::iterator it)
+{
+    auto [begin, end] = m_index.equal_range(it->key);
+    for (auto indexIt = begin; indexIt != end; ++indexIt)
+    {
+        if (indexIt->second == it)
+        {
+            m_index.erase(indexIt);
+            break;
+        }
+    }
+    m_size -= GetEntrySize(*it);
+    m_entries.erase(it);
+    m_dirty = true;
+}
+
+void ProgramBinaryCache::EvictUntil(size_t sizeLimit)
+{
+    while (m_size > sizeLimit && !m_entries.empty())
+    {
+        Erase(std::prev(m_entries.end()));
+    }
+}
@@ -0,0 +1,124 @@
+#include "Render/ProgramCache.h"
+
+#include <algorithm>
+#include <vector>
+#include <glad/glad.h>
+
+#include "Render/ParameterBuffer.h"
+
+ShaderProgram::~ShaderProgram()
+{
+    glDeleteProgram(m_id);
+}
+
+void ShaderProgram::Reflect()
+{
+    m_layout = {};
+    // -1 for a member of a block
+    m_layout.timeLocation = glGetUniformLocation(m_id, "Time");
+
+    const GLuint globalsIndex = glGetUniformBlockIndex(m_id, c_globalsBlockName);
+    if (globalsIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_id, globalsIndex, c_globalsBinding);
+
+    const GLuint parametersIndex = glGetUniformBlockIndex(m_id, c_parametersBlockName);
+    if (parametersIndex == GL_INVALID_INDEX)
+        return;
+    glUniformBlockBinding(m_id, parametersIndex, c_parametersBinding);
+
+    GLint size = 0;
+    GLint memberCount = 0;
+    glGetActiveUniformBlockiv(m_id, parametersIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+    glGetActiveUniformBlockiv(m_id, parametersIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+    if (size <= 0 || memberCount <= 0)
+        return;
+
+    std::vector<GLint> indices(memberCount);
+    std::vector<GLint> offsets(memberCount);
+    glGetActiveUniformBlockiv(m_id, parametersIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+    glGetActiveUniformsiv(m_id, memberCount, reinterpret_cast<const GLuint*>(indices.data()), GL_UNIFORM_OFFSET, offsets.data());
+    char name[256];
+    for (GLint i = 0; i < memberCount; i++)
+    {
+        glGetActiveUniformName(m_id, static_cast<GLuint>(indices[i]), sizeof(name), nullptr, name);
+        m_layout.offsets.emplace(name, static_cast<uint32_t>(offsets[i]));
+    }
+    m_layout.parametersSize = static_cast<uint32_t>(size);
+}
+
+ProgramCache& ProgramCache::GetInstance()
+{
+    static ProgramCache cache;
+    return cache;
+}
+
+uint64_t ProgramCache::GetKey(uint64_t vertexHash, const std::string& fragmentSource)
+{
+    return std::hash<std::string>{}(fragmentSource) ^ (vertexHash * 0x9e3779b97f4a7c15ull);
+}
+
+ShaderProgramRef ProgramCache::Find(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource)
+{
+    auto [begin, end] = m_index.equal_range(key);
+    for (auto it = begin; it != end; ++it)
+    {
+        const Entry& entry = *it->second;
+        if (entry.vertexHash != vertexHash || entry.fragmentSource != fragmentSource)
+            continue;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        m_hitCount++;
+        return entry.program;
+    }
+    m_missCount++;
+    return nullptr;
+}
+
+ShaderProgramRef ProgramCache::Add(uint64_t key, uint64_t vertexHash, const std::string& fragmentSource, const ShaderProgramRef& program)
+{
+    auto [begin, end] = m_index.equal_range(key);
+    for (auto it = begin; it != end; ++it)
+    {
+        if (it->second->vertexHash == vertexHash && it->second->fragmentSource == fragmentSource)
+            return it->second->program;
+    }
+
+    m_entries.push_front({ key, vertexHash, fragmentSource, program });
+    m_index.emplace(key, m_entries.begin());
+    m_memoryUsage += GetEntrySize(m_entries.front());
+
+    // The new program is kept even if it is bigger than the cap on its own
+    EvictUntil(std::max(m_memoryCap, GetEntrySize(m_entries.front())));
+    return program;
+}
+
+void ProgramCache::Clear()
+{
+    m_index.clear();
+    m_entries.clear();
+    m_memoryUsage = 0;
+}
+
+void ProgramCache::SetMemoryCap(size_t memoryCap)
+{
+    m_memoryCap = memoryCap;
+    EvictUntil(m_memoryCap);
+}
+
+void ProgramCache::EvictUntil(size_t memoryCap)
+{
+    while (m_memoryUsage > memoryCap && !m_entries.empty())
+    {
+        const Entry& entry = m_entries.back();
+        auto [begin, end] = m_index.equal_range(entry.key);
+        for (auto it = begin; it != end; ++it)
+        {
+            if (&*it->second == &entry)
+            {
+                m_index.erase(it);
+                break;
+            }
+        }
+        m_memoryUsage -= GetEntrySize(entry);
+        m_entries.pop_back();
+    }
+}
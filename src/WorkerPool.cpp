@@ -0,0 +1,77 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(uint32_t threadCount)
+{
+    m_threads.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        m_threads.emplace_back([this](const std::stop_token& stopToken) { WorkerLoop(stopToken); });
+    }
+}
+
+WorkerPool& WorkerPool::GetInstance()
+{
+    static WorkerPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+void WorkerPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+{
+    if (count == 0)
+        return;
+    if (m_threads.empty() || count == 1)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    {
+        std::scoped_lock lock(m_mutex);
+        m_func = &func;
+        m_count = count;
+        m_nextIndex = 0;
+        m_runningWorkers = static_cast<uint32_t>(m_threads.size());
+        m_generation++;
+    }
+    m_wakeCondition.notify_all();
+
+    RunIterations();
+
+    // The workers read func until they are done with this loop
+    std::unique_lock lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_runningWorkers == 0; });
+    m_func = nullptr;
+}
+
+void WorkerPool::WorkerLoop(const std::stop_token& stopToken)
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_wakeCondition.wait(lock, stopToken, [&] { return m_generation != generation; }))
+                return;
+            generation = m_generation;
+        }
+
+        RunIterations();
+
+        std::scoped_lock lock(m_mutex);
+        if (--m_runningWorkers == 0)
+            m_doneCondition.notify_one();
+    }
+}
+
+void WorkerPool::RunIterations()
+{
+    for (uint32_t i = m_nextIndex++; i < m_count; i = m_nextIndex++)
+    {
+        (*m_func)(i);
+    }
+}